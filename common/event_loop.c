@@ -0,0 +1,102 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+#include "event_loop.h"
+#include "log.h"
+
+struct event_loop
+{
+    // [0] is the timerfd, the watched fds follow
+    struct pollfd *fds;
+    int count;
+    int capacity;
+};
+
+struct event_loop *event_loop_create()
+{
+    struct event_loop *loop = calloc(1, sizeof(*loop));
+    if (!loop)
+    {
+        logerror("calloc failed");
+        return NULL;
+    }
+
+    int timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer < 0 || event_loop_add(loop, timer) != 0)
+    {
+        logerror("timerfd_create failed");
+        if (timer >= 0)
+            close(timer);
+        free(loop);
+        return NULL;
+    }
+
+    return loop;
+}
+
+int event_loop_add(struct event_loop *loop, int fd)
+{
+    if (loop->count == loop->capacity)
+    {
+        int capacity = loop->capacity ? loop->capacity * 2 : 8;
+        struct pollfd *fds = realloc(loop->fds, capacity * sizeof(*fds));
+        if (!fds)
+        {
+            logerror("realloc failed");
+            return -1;
+        }
+        loop->fds = fds;
+        loop->capacity = capacity;
+    }
+    loop->fds[loop->count++] = (struct pollfd){.fd = fd, .events = POLLIN};
+    return 0;
+}
+
+int event_loop_set_clock(struct event_loop *loop, double fps)
+{
+    struct itimerspec spec = {0};
+    if (fps > 0)
+    {
+        uint64_t period_ns = 1e9 / fps;
+        spec.it_interval.tv_sec = period_ns / 1000000000;
+        spec.it_interval.tv_nsec = period_ns % 1000000000;
+        spec.it_value = spec.it_interval;
+    }
+    if (timerfd_settime(loop->fds[0].fd, 0, &spec, NULL) != 0)
+    {
+        logerror("timerfd_settime failed");
+        return -1;
+    }
+    return 0;
+}
+
+int event_loop_wait(struct event_loop *loop, int timeout_ms)
+{
+    int ret;
+    do
+        ret = poll(loop->fds, loop->count, timeout_ms);
+    while (ret < 0 && errno == EINTR);
+    if (ret < 0)
+    {
+        logerror("poll failed");
+        return -1;
+    }
+
+    uint64_t ticks = 0;
+    if ((loop->fds[0].revents & POLLIN) && read(loop->fds[0].fd, &ticks, sizeof(ticks)) != sizeof(ticks))
+        ticks = 0;
+    return (int)ticks;
+}
+
+void event_loop_destroy(struct event_loop *loop)
+{
+    if (!loop)
+        return;
+
+    close(loop->fds[0].fd);
+    free(loop->fds);
+    free(loop);
+}
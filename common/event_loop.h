@@ -0,0 +1,31 @@
+#ifndef EVENT_LOOP_H__
+#define EVENT_LOOP_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+    struct event_loop;
+
+    struct event_loop *event_loop_create();
+
+    // wake event_loop_wait while <fd> is readable, e.g. ConnectionNumber of an X display
+    // or an eventfd; the caller drains it, it stays owned by the caller
+    int event_loop_add(struct event_loop *loop, int fd);
+
+    // periodic frame clock from a timerfd, first tick one period from now; 0 stops it
+    int event_loop_set_clock(struct event_loop *loop, double fps);
+
+    // block until a watched fd is readable or the clock ticks, at most <timeout_ms>
+    // (-1: forever, 0: just check); returns the clock ticks since the previous wait,
+    // more than 1 if some were missed, -1 on error
+    int event_loop_wait(struct event_loop *loop, int timeout_ms);
+
+    // NULL-safe
+    void event_loop_destroy(struct event_loop *loop);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // EVENT_LOOP_H__
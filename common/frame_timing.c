@@ -0,0 +1,292 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "frame_timing.h"
+#include "log.h"
+#include "trace.h"
+
+#define TIMING_DEFAULT_FRAMES 65536
+// log-linear buckets: 16 per power of two (< 6.25% error), up to ~2^40 ns
+#define HIST_SUB_BITS 4
+#define HIST_SUB (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS (40 * HIST_SUB)
+
+struct histogram
+{
+    uint32_t buckets[HIST_BUCKETS];
+    size_t count;
+    uint64_t max;
+};
+
+struct timing_row
+{
+    uint64_t start_ns;
+    uint64_t stage_ns[TIMING_STAGE_COUNT];
+};
+
+static const char *stage_names[TIMING_STAGE_COUNT] = {
+    "events", "acquire", "upload", "draw", "swap", "frame", "gpu_upload", "gpu_draw"};
+
+static struct
+{
+    int ready;
+    int report_ms;
+    char *csv_path;
+
+    struct histogram interval[TIMING_STAGE_COUNT];
+    struct histogram total[TIMING_STAGE_COUNT];
+
+    // raw series, a ring of the last <capacity> frames
+    struct timing_row *rows;
+    size_t capacity;
+    size_t frames;
+
+    uint64_t start_ns;  // first timing_init
+    uint64_t frame_ns;  // end of the previous frame
+    uint64_t last_ns;   // previous mark
+    uint64_t report_ns; // start of the current interval
+    uint64_t stage_ns[TIMING_STAGE_COUNT];
+    unsigned marked; // stages marked in the current frame
+    // timing_record() for the current frame, copied into its row at frame end
+    uint64_t pending_ns[TIMING_STAGE_COUNT];
+} timing_;
+
+uint64_t timing_now_ns()
+{
+    struct timespec tp;
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return (uint64_t)tp.tv_sec * 1000000000 + tp.tv_nsec;
+}
+
+static int bucket_index(uint64_t v)
+{
+    if (v < HIST_SUB)
+        return v;
+    int e = 63 - __builtin_clzll(v);
+    int idx = (e - HIST_SUB_BITS + 1) * HIST_SUB + ((v >> (e - HIST_SUB_BITS)) & (HIST_SUB - 1));
+    return idx < HIST_BUCKETS ? idx : HIST_BUCKETS - 1;
+}
+
+// highest value that lands in bucket <idx>
+static uint64_t bucket_upper(int idx)
+{
+    if (idx < HIST_SUB)
+        return idx;
+    int e = idx / HIST_SUB + HIST_SUB_BITS - 1;
+    uint64_t lower = (uint64_t)(HIST_SUB + idx % HIST_SUB) << (e - HIST_SUB_BITS);
+    return lower + ((uint64_t)1 << (e - HIST_SUB_BITS)) - 1;
+}
+
+static void hist_add(struct histogram *h, uint64_t v)
+{
+    h->buckets[bucket_index(v)]++;
+    h->count++;
+    if (v > h->max)
+        h->max = v;
+}
+
+static uint64_t hist_percentile(const struct histogram *h, double p)
+{
+    if (h->count == 0)
+        return 0;
+    size_t rank = (size_t)(p * h->count + 0.5);
+    if (rank == 0)
+        rank = 1;
+    size_t seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++)
+    {
+        seen += h->buckets[i];
+        if (seen >= rank)
+        {
+            uint64_t v = bucket_upper(i);
+            return v < h->max ? v : h->max;
+        }
+    }
+    return h->max;
+}
+
+static void log_histograms(const char *what, const struct histogram *hists, double seconds)
+{
+    char line[1024];
+    int len = 0;
+    for (int s = 0; s < TIMING_STAGE_COUNT; s++)
+    {
+        const struct histogram *h = &hists[s];
+        if (h->count == 0)
+            continue;
+        len += snprintf(line + len, sizeof(line) - len, ", %s %.2f/%.2f/%.2f/%.2f",
+            stage_names[s], hist_percentile(h, 0.5) / 1e6, hist_percentile(h, 0.9) / 1e6,
+            hist_percentile(h, 0.99) / 1e6, h->max / 1e6);
+        if (len >= (int)sizeof(line))
+            break;
+    }
+
+    size_t frames = hists[TIMING_FRAME].count;
+    loginfo("%s: %zu frames, %.1f fps, p50/p90/p99/max ms%s",
+        what, frames, seconds > 0 ? frames / seconds : 0, len > 0 ? line : "");
+}
+
+int timing_init(size_t max_frames, int report_ms, const char *csv_path)
+{
+    if (timing_.ready)
+        timing_destroy();
+
+    memset(&timing_, 0, sizeof(timing_));
+    timing_.capacity = max_frames > 0 ? max_frames : TIMING_DEFAULT_FRAMES;
+    timing_.report_ms = report_ms;
+
+    if (!csv_path)
+        csv_path = getenv("FRAME_TIMING_CSV");
+    if (csv_path && csv_path[0])
+    {
+        timing_.csv_path = strdup(csv_path);
+        timing_.rows = calloc(timing_.capacity, sizeof(*timing_.rows));
+        if (!timing_.csv_path || !timing_.rows)
+        {
+            logerror("timing: out of memory for %zu rows", timing_.capacity);
+            free(timing_.csv_path);
+            free(timing_.rows);
+            timing_.csv_path = NULL;
+            timing_.rows = NULL;
+            return -1;
+        }
+    }
+
+    timing_.start_ns = timing_.frame_ns = timing_.last_ns = timing_.report_ns = timing_now_ns();
+    timing_.ready = 1;
+
+    return 0;
+}
+
+void timing_mark(enum timing_stage stage)
+{
+    if (!timing_.ready)
+        return;
+
+    uint64_t now = timing_now_ns();
+    if (trace_enabled_)
+        trace_end(stage_names[stage], timing_.last_ns);
+    timing_.stage_ns[stage] += now - timing_.last_ns;
+    timing_.marked |= 1u << stage;
+    timing_.last_ns = now;
+}
+
+void timing_record(size_t frame, enum timing_stage stage, uint64_t ns)
+{
+    if (!timing_.ready || frame > timing_.frames)
+        return;
+
+    hist_add(&timing_.interval[stage], ns);
+    hist_add(&timing_.total[stage], ns);
+
+    // the current frame's row is written at timing_frame_end
+    if (frame == timing_.frames)
+        timing_.pending_ns[stage] = ns;
+    else if (timing_.rows && timing_.frames - frame < timing_.capacity)
+        timing_.rows[frame % timing_.capacity].stage_ns[stage] = ns;
+}
+
+size_t timing_frame_index()
+{
+    return timing_.frames;
+}
+
+void timing_frame_end()
+{
+    if (!timing_.ready)
+        return;
+
+    uint64_t now = timing_now_ns();
+    if (trace_enabled_)
+        trace_end(stage_names[TIMING_FRAME], timing_.frame_ns);
+    timing_.stage_ns[TIMING_FRAME] = now - timing_.frame_ns;
+    timing_.marked |= 1u << TIMING_FRAME;
+
+    for (int s = 0; s < TIMING_STAGE_COUNT; s++)
+    {
+        if (!(timing_.marked & (1u << s)))
+            continue;
+        hist_add(&timing_.interval[s], timing_.stage_ns[s]);
+        hist_add(&timing_.total[s], timing_.stage_ns[s]);
+    }
+
+    if (timing_.rows)
+    {
+        struct timing_row *row = &timing_.rows[timing_.frames % timing_.capacity];
+        row->start_ns = timing_.frame_ns - timing_.start_ns;
+        memcpy(row->stage_ns, timing_.stage_ns, sizeof(row->stage_ns));
+        for (int s = 0; s < TIMING_STAGE_COUNT; s++)
+            if (timing_.pending_ns[s])
+                row->stage_ns[s] = timing_.pending_ns[s];
+    }
+    memset(timing_.pending_ns, 0, sizeof(timing_.pending_ns));
+    timing_.frames++;
+
+    memset(timing_.stage_ns, 0, sizeof(timing_.stage_ns));
+    timing_.marked = 0;
+    timing_.frame_ns = timing_.last_ns = now;
+
+    if (timing_.report_ms > 0 && now - timing_.report_ns >= (uint64_t)timing_.report_ms * 1000000)
+        timing_report();
+}
+
+void timing_report()
+{
+    if (!timing_.ready)
+        return;
+
+    uint64_t now = timing_now_ns();
+    log_histograms("timing", timing_.interval, (now - timing_.report_ns) / 1e9);
+    memset(timing_.interval, 0, sizeof(timing_.interval));
+    timing_.report_ns = now;
+}
+
+static int dump_csv(const char *path)
+{
+    FILE *fp = fopen(path, "w");
+    if (!fp)
+    {
+        logerror("timing: fopen %s failed", path);
+        return -1;
+    }
+
+    fprintf(fp, "frame,start_us");
+    for (int s = 0; s < TIMING_STAGE_COUNT; s++)
+        fprintf(fp, ",%s_us", stage_names[s]);
+    fprintf(fp, "\n");
+
+    size_t first = timing_.frames > timing_.capacity ? timing_.frames - timing_.capacity : 0;
+    for (size_t i = first; i < timing_.frames; i++)
+    {
+        const struct timing_row *row = &timing_.rows[i % timing_.capacity];
+        fprintf(fp, "%zu,%.3f", i, row->start_ns / 1e3);
+        for (int s = 0; s < TIMING_STAGE_COUNT; s++)
+            fprintf(fp, ",%.3f", row->stage_ns[s] / 1e3);
+        fprintf(fp, "\n");
+    }
+
+    if (fclose(fp) != 0)
+    {
+        logerror("timing: write %s failed", path);
+        return -1;
+    }
+    loginfo("timing: %zu frames written to %s", timing_.frames - first, path);
+
+    return 0;
+}
+
+void timing_destroy()
+{
+    if (!timing_.ready)
+        return;
+
+    if (timing_.frames > 0)
+        log_histograms("timing total", timing_.total, (timing_now_ns() - timing_.start_ns) / 1e9);
+    if (timing_.csv_path && timing_.frames > 0)
+        dump_csv(timing_.csv_path);
+
+    free(timing_.csv_path);
+    free(timing_.rows);
+    memset(&timing_, 0, sizeof(timing_));
+}
@@ -0,0 +1,56 @@
+#ifndef FRAME_TIMING_H__
+#define FRAME_TIMING_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#include <stddef.h>
+#include <stdint.h>
+
+    enum timing_stage
+    {
+        TIMING_EVENTS,     // window event pump, and sleeping for the next event when idle
+        TIMING_ACQUIRE,    // next frame from the source
+        TIMING_UPLOAD,     // texture upload
+        TIMING_DRAW,       // clear + draw calls
+        TIMING_SWAP,       // eglSwapBuffers / headless throttle
+        TIMING_FRAME,      // whole frame, end to end
+        TIMING_GPU_UPLOAD, // GPU time of the upload, reported late by gpu_timer
+        TIMING_GPU_DRAW,   // GPU time of the draw
+        TIMING_STAGE_COUNT,
+    };
+
+    // keep the last <max_frames> per-frame rows for the CSV dump (0: default 65536)
+    // and log per-stage p50/p90/p99/max every <report_ms> (0: never);
+    // csv_path NULL falls back to $FRAME_TIMING_CSV, unset means no dump
+    int timing_init(size_t max_frames, int report_ms, const char *csv_path);
+
+    uint64_t timing_now_ns();
+
+    // charge the time since the previous mark (or frame end) to <stage>,
+    // also recorded as a trace span when tracing is on
+    void timing_mark(enum timing_stage stage);
+
+    // record a duration measured elsewhere for frame <frame>, e.g. a GPU query
+    // that resolved a few frames later; the CSV row is updated while still kept
+    void timing_record(size_t frame, enum timing_stage stage, uint64_t ns);
+
+    // index of the frame currently being timed
+    size_t timing_frame_index();
+
+    // close the frame: record its rows into the histograms and the raw series,
+    // report if the period elapsed
+    void timing_frame_end();
+
+    // log percentiles of the current interval and start a new one
+    void timing_report();
+
+    // log percentiles over the whole run, write the CSV if configured, free everything
+    void timing_destroy();
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // FRAME_TIMING_H__
@@ -3,39 +3,363 @@
 #include <time.h>
 #include <stdarg.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <limits.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
 #include "log.h"
 
+#define LOG_LINE_SIZE 2048
+// message bytes carried by one async record, longer messages are truncated
+#define LOG_MSG_SIZE 488
+// records per producer thread, power of two
+#define LOG_RING_SIZE 512
+// longest sleep of the writer and of log_flush, a missed wake costs at most this
+#define LOG_IDLE_SEC 1
+
 static enum log_level log_level_ = LOG_LEVEL_WARN;
-static char fmt_str[2048];
 static int level_colors[] = {37, 34, 33, 31, 31};
 static char *level_names[] = {"DEBUG", "INFO ", "WARN ", "ERROR", "FATAL"};
-char time_str[32];
+
+struct log_record
+{
+    uint64_t seq;
+    struct timespec ts;
+    const char *file;
+    const char *func;
+    int line;
+    int level;
+    char msg[LOG_MSG_SIZE];
+};
+
+// single producer (the owning thread), single consumer (the writer thread)
+struct log_ring
+{
+    _Atomic size_t head;
+    _Atomic size_t tail;
+    _Atomic size_t dropped; // records lost because the ring was full
+    _Atomic int orphaned;   // the owner exited, the next thread to log takes the ring over
+    struct log_ring *next;
+    struct log_record records[LOG_RING_SIZE];
+};
+
+static _Atomic int async_;
+static _Atomic int stopping_;
+static _Atomic uint64_t seq_;     // records queued
+static _Atomic uint64_t written_; // records handed to stderr
+static struct log_ring *_Atomic rings_;
+static __thread struct log_ring *ring_;
+static pthread_key_t ring_key_; // only for its destructor, ring_ is the fast path
+static pthread_once_t ring_key_once_ = PTHREAD_ONCE_INIT;
+static pthread_t writer_;
+// futex words: wake_ is bumped to wake the sleeping writer, flushed_ after each drain
+static _Atomic uint32_t wake_;
+static _Atomic uint32_t flushed_;
+// set while the writer / some log_flush sleeps, so producers only make the syscall then
+static _Atomic uint32_t writer_waiting_;
+static _Atomic uint32_t flush_waiting_;
 
 void set_log_level(enum log_level level)
 {
     log_level_ = level;
 }
 
+static int format_header(char *buf, size_t size, int level, const struct timespec *ts,
+    const char *file, int line, const char *func)
+{
+    char time_str[32];
+    struct tm tm;
+    time_t t = ts->tv_sec;
+    strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", localtime_r(&t, &tm));
+
+    return snprintf(buf, size, "\033[1;%dm[%s]\033[0m \033[32m%s \033[35m%s:%d \033[36m%s()\033[0m ",
+        level_colors[level], level_names[level], time_str, file, line, func);
+}
+
+// header + message + newline into buf, returns the length written
+static size_t format_line(char *buf, size_t size, int level, const struct timespec *ts,
+    const char *file, int line, const char *func, const char *msg)
+{
+    int len = format_header(buf, size, level, ts, file, line, func);
+    if (len < 0)
+        return 0;
+    if ((size_t)len >= size)
+        len = size - 1;
+
+    size_t msg_len = strlen(msg);
+    if (msg_len > 0 && msg[msg_len - 1] == '\n')
+        msg_len--;
+    if (msg_len > size - len - 2)
+        msg_len = size - len - 2;
+    memcpy(buf + len, msg, msg_len);
+    len += msg_len;
+    buf[len++] = '\n';
+    buf[len] = '\0';
+
+    return len;
+}
+
+static void futex_wait(_Atomic uint32_t *word, uint32_t expected)
+{
+    struct timespec ts = {LOG_IDLE_SEC, 0};
+    syscall(SYS_futex, (uint32_t *)word, FUTEX_WAIT_PRIVATE, expected, &ts, NULL, 0);
+}
+
+static void futex_wake(_Atomic uint32_t *word)
+{
+    atomic_fetch_add(word, 1);
+    syscall(SYS_futex, (uint32_t *)word, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+// thread exit: hand the ring on, whatever is still queued in it gets written all the same
+static void orphan_ring(void *arg)
+{
+    struct log_ring *ring = arg;
+    ring_ = NULL;
+    atomic_store(&ring->orphaned, 1);
+}
+
+static void create_ring_key(void)
+{
+    pthread_key_create(&ring_key_, orphan_ring);
+}
+
+static struct log_ring *get_ring(void)
+{
+    if (ring_)
+        return ring_;
+
+    pthread_once(&ring_key_once_, create_ring_key);
+
+    // rings are only ever added, the writer walks the list without a lock, so rather than
+    // free one, a new thread adopts a ring left by an exited one: there are only ever as
+    // many as threads have logged at the same time
+    struct log_ring *ring;
+    for (ring = atomic_load(&rings_); ring; ring = ring->next)
+    {
+        int orphaned = 1;
+        if (atomic_compare_exchange_strong(&ring->orphaned, &orphaned, 0))
+            break;
+    }
+    if (!ring)
+    {
+        ring = calloc(1, sizeof(*ring));
+        if (!ring)
+            return NULL;
+        ring->next = atomic_load(&rings_);
+        while (!atomic_compare_exchange_weak(&rings_, &ring->next, ring))
+            ;
+    }
+
+    pthread_setspecific(ring_key_, ring);
+    ring_ = ring;
+    return ring;
+}
+
+// returns 0 if the record was queued, -1 to fall back to the synchronous path
+static int log_async_(enum log_level level, const char *file, int line, const char *func,
+    const char *fmt, va_list args)
+{
+    struct log_ring *ring = get_ring();
+    if (!ring)
+        return -1;
+
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail == LOG_RING_SIZE)
+    {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return 0;
+    }
+
+    struct log_record *rec = &ring->records[head & (LOG_RING_SIZE - 1)];
+    clock_gettime(CLOCK_REALTIME, &rec->ts);
+    rec->seq = atomic_fetch_add_explicit(&seq_, 1, memory_order_relaxed);
+    rec->file = file;
+    rec->func = func;
+    rec->line = line;
+    rec->level = level;
+    vsnprintf(rec->msg, LOG_MSG_SIZE, fmt, args);
+
+    // seq_cst store then loads, paired with the writer's store of writer_waiting_ then loads of
+    // head: either it sees this record, or this sees it waiting with the ring drained up to here
+    atomic_store(&ring->head, head + 1);
+    if (atomic_load(&ring->tail) == head && atomic_load(&writer_waiting_))
+        futex_wake(&wake_);
+    return 0;
+}
+
+// write out every queued record, oldest first across threads
+static void drain(void)
+{
+    static char out[64 * 1024];
+    size_t out_len = 0;
+    uint64_t count = 0;
+
+    for (;;)
+    {
+        struct log_ring *oldest = NULL;
+        struct log_record *rec = NULL;
+        for (struct log_ring *ring = atomic_load(&rings_); ring; ring = ring->next)
+        {
+            size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+            if (tail == atomic_load_explicit(&ring->head, memory_order_acquire))
+                continue;
+            struct log_record *r = &ring->records[tail & (LOG_RING_SIZE - 1)];
+            if (!rec || r->seq < rec->seq)
+            {
+                oldest = ring;
+                rec = r;
+            }
+        }
+        if (!rec)
+            break;
+
+        if (out_len + LOG_LINE_SIZE > sizeof(out))
+        {
+            fwrite(out, 1, out_len, stderr);
+            out_len = 0;
+        }
+        out_len += format_line(out + out_len, LOG_LINE_SIZE, rec->level, &rec->ts,
+            rec->file, rec->line, rec->func, rec->msg);
+
+        atomic_fetch_add(&oldest->tail, 1);
+        count++;
+    }
+
+    for (struct log_ring *ring = atomic_load(&rings_); ring; ring = ring->next)
+    {
+        size_t dropped = atomic_exchange_explicit(&ring->dropped, 0, memory_order_relaxed);
+        if (dropped > 0)
+        {
+            if (out_len + LOG_LINE_SIZE > sizeof(out))
+            {
+                fwrite(out, 1, out_len, stderr);
+                out_len = 0;
+            }
+            out_len += snprintf(out + out_len, LOG_LINE_SIZE, "[log: %zu records dropped]\n", dropped);
+        }
+    }
+
+    if (out_len > 0)
+    {
+        fwrite(out, 1, out_len, stderr);
+        fflush(stderr);
+    }
+    atomic_fetch_add(&written_, count);
+    if (count > 0 && atomic_load(&flush_waiting_))
+        futex_wake(&flushed_);
+}
+
+static int rings_empty(void)
+{
+    for (struct log_ring *ring = atomic_load(&rings_); ring; ring = ring->next)
+        if (atomic_load(&ring->head) != atomic_load_explicit(&ring->tail, memory_order_relaxed))
+            return 0;
+    return 1;
+}
+
+static void *writer_thread(void *arg)
+{
+    (void)arg;
+
+    while (!atomic_load(&stopping_))
+    {
+        drain();
+
+        // sleep until a producer queues into an empty ring, waking anyway now and
+        // then to report records dropped meanwhile
+        uint32_t wake = atomic_load(&wake_);
+        atomic_store(&writer_waiting_, 1);
+        if (rings_empty() && !atomic_load(&stopping_))
+            futex_wait(&wake_, wake);
+        atomic_store(&writer_waiting_, 0);
+    }
+    drain();
+
+    return NULL;
+}
+
+void log_flush(void)
+{
+    if (!atomic_load(&async_))
+        return;
+    uint64_t target = atomic_load(&seq_);
+    atomic_fetch_add(&flush_waiting_, 1);
+    for (;;)
+    {
+        uint32_t flushed = atomic_load(&flushed_);
+        if (atomic_load(&written_) >= target)
+            break;
+        futex_wait(&flushed_, flushed);
+    }
+    atomic_fetch_sub(&flush_waiting_, 1);
+}
+
+int log_async_start(void)
+{
+    static int registered = 0;
+
+    if (atomic_load(&async_))
+        return 0;
+
+    atomic_store(&stopping_, 0);
+    if (pthread_create(&writer_, NULL, writer_thread, NULL) != 0)
+    {
+        logerror("pthread_create failed, keep synchronous logging");
+        return -1;
+    }
+    if (!registered)
+    {
+        atexit(log_async_stop);
+        registered = 1;
+    }
+    atomic_store(&async_, 1);
+
+    return 0;
+}
+
+void log_async_stop(void)
+{
+    if (!atomic_load(&async_))
+        return;
+
+    atomic_store(&async_, 0);
+    atomic_store(&stopping_, 1);
+    futex_wake(&wake_);
+    pthread_join(writer_, NULL);
+}
+
 void log_(enum log_level level, const char *file, int line, const char *func, const char *fmt, ...)
 {
     if (level < log_level_)
         return;
 
-    time_t t = time(NULL);
-    strftime(time_str, 32, "%Y-%m-%d %H:%M:%S", localtime(&t));
-
-    snprintf(fmt_str, 2048, "\033[1;%dm[%s]\033[0m \033[32m%s \033[35m%s:%d \033[36m%s()\033[0m ",
-        level_colors[level], level_names[level], time_str, file, line, func);
     va_list args;
-
     va_start(args, fmt);
-    vsnprintf(fmt_str + strlen(fmt_str), 2048, fmt, args);
-    va_end(args);
 
-    if (fmt_str[strlen(fmt_str) - 1] != '\n')
-        strncat(fmt_str, "\n", 2);
+    if (level != LOG_LEVEL_FATAL && atomic_load_explicit(&async_, memory_order_relaxed) &&
+        log_async_(level, file, line, func, fmt, args) == 0)
+    {
+        va_end(args);
+        return;
+    }
 
-    fprintf(stderr, "%s", fmt_str);
+    // fatal records must not be lost: write everything queued before them first
+    if (level == LOG_LEVEL_FATAL)
+        log_flush();
+
+    char msg[LOG_LINE_SIZE];
+    char line_str[LOG_LINE_SIZE];
+    struct timespec ts;
+    vsnprintf(msg, sizeof(msg), fmt, args);
+    va_end(args);
+    clock_gettime(CLOCK_REALTIME, &ts);
+    size_t len = format_line(line_str, sizeof(line_str), level, &ts, file, line, func, msg);
+    fwrite(line_str, 1, len, stderr);
 
     if (level == LOG_LEVEL_FATAL)
         exit(-1);
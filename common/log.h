@@ -1,5 +1,5 @@
 #ifndef LOG_H__
-#endif // LOG_H__
+#define LOG_H__
 
 #ifdef __cplusplus
 extern "C"
@@ -15,37 +15,82 @@ extern "C"
         LOG_LEVEL_FATAL,
     };
 
+// compile-time floor: calls below it expand to nothing, arguments included.
+// 0 debug .. 4 fatal, release (NDEBUG) builds drop logdebug by default
+#ifndef LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define LOG_MIN_LEVEL 1
+#else
+#define LOG_MIN_LEVEL 0
+#endif // NDEBUG
+#endif // LOG_MIN_LEVEL
+
     void set_log_level(enum log_level level);
-    void log_(enum log_level level, const char *file, int line, const char *func, const char *fmt, ...);
+    void log_(enum log_level level, const char *file, int line, const char *func, const char *fmt, ...)
+        __attribute__((format(printf, 5, 6)));
 
+    // switch to the asynchronous backend: log_() only formats the message into
+    // a per-thread lock-free ring, a background thread adds the header and
+    // writes to stderr. a full ring drops the record rather than blocking and
+    // the writer reports how many were lost. flushed at exit and before a
+    // fatal record
+    int log_async_start(void);
+    // drain every ring and wait until the records are written
+    void log_flush(void);
+    // flush and go back to synchronous logging
+    void log_async_stop(void);
+
+#define LOG_NOP_ \
+    do           \
+    {            \
+    }            \
+    while (0);
+
+#if LOG_MIN_LEVEL <= 0
 #define logdebug(fmt, ...)                                                      \
     do                                                                           \
     {                                                                            \
         log_(LOG_LEVEL_DEBUG, __FILE__, __LINE__, __func__, fmt, ##__VA_ARGS__); \
     }                                                                            \
     while (0);
+#else
+#define logdebug(fmt, ...) LOG_NOP_
+#endif
 
+#if LOG_MIN_LEVEL <= 1
 #define loginfo(fmt, ...)                                                      \
     do                                                                          \
     {                                                                           \
         log_(LOG_LEVEL_INFO, __FILE__, __LINE__, __func__, fmt, ##__VA_ARGS__); \
     }                                                                           \
     while (0);
+#else
+#define loginfo(fmt, ...) LOG_NOP_
+#endif
 
+#if LOG_MIN_LEVEL <= 2
 #define logwarn(fmt, ...)                                                      \
     do                                                                          \
     {                                                                           \
         log_(LOG_LEVEL_WARN, __FILE__, __LINE__, __func__, fmt, ##__VA_ARGS__); \
     }                                                                           \
     while (0);
+#else
+#define logwarn(fmt, ...) LOG_NOP_
+#endif
 
+#if LOG_MIN_LEVEL <= 3
 #define logerror(fmt, ...)                                                      \
     do                                                                           \
     {                                                                            \
         log_(LOG_LEVEL_ERROR, __FILE__, __LINE__, __func__, fmt, ##__VA_ARGS__); \
     }                                                                            \
     while (0);
+#else
+#define logerror(fmt, ...) LOG_NOP_
+#endif
 
+// fatal is never elided, it terminates the process
 #define logfatal(fmt, ...)                                                      \
     do                                                                           \
     {                                                                            \
@@ -57,5 +102,4 @@ extern "C"
 }
 #endif // __cplusplus
 
-#ifndef LOG_H__
-#endif // LOG_H__
\ No newline at end of file
+#endif // LOG_H__
@@ -0,0 +1,265 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "program_cache.h"
+#include "log.h"
+
+#define PROGRAM_CACHE_MAGIC 0x43424750 // "PGBC"
+#define PROGRAM_CACHE_VERSION 1
+
+struct program_cache_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t binary_format;
+    uint32_t length;
+};
+
+// renderers on several threads build programs at once, each on its own context
+static pthread_mutex_t lock_ = PTHREAD_MUTEX_INITIALIZER;
+
+static char dir_[512];
+static int dir_init_;
+static int disabled_;
+
+static size_t hits_;
+static size_t misses_;
+static size_t rejects_; // present on disk, refused by the driver
+static double load_ms_;
+static double compile_ms_;
+static unsigned tmp_seq_;
+
+static double now_ms()
+{
+    struct timespec tp;
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return tp.tv_sec * 1e3 + tp.tv_nsec / 1e6;
+}
+
+// FNV-1a, strings are hashed with their terminator so "ab"+"c" != "a"+"bc"
+static uint64_t hash_string(uint64_t hash, const char *str)
+{
+    const unsigned char *p = (const unsigned char *)(str ? str : "");
+    do
+    {
+        hash ^= *p;
+        hash *= 0x100000001b3ULL;
+    }
+    while (*p++);
+    return hash;
+}
+
+static const char *cache_dir()
+{
+    pthread_mutex_lock(&lock_);
+    if (!dir_init_)
+    {
+        dir_init_ = 1;
+        const char *env = getenv("PROGRAM_CACHE_DIR");
+        const char *home = getenv("HOME");
+        if (env)
+            snprintf(dir_, sizeof(dir_), "%s", env);
+        else if (home)
+            snprintf(dir_, sizeof(dir_), "%s/.cache/opengles-test", home);
+        else
+            disabled_ = 1;
+        if (dir_[0] == '\0')
+            disabled_ = 1;
+    }
+    pthread_mutex_unlock(&lock_);
+    return disabled_ ? NULL : dir_;
+}
+
+static void make_dirs(const char *dir)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s", dir);
+    for (char *p = path + 1; *p; ++p)
+    {
+        if (*p == '/')
+        {
+            *p = '\0';
+            mkdir(path, 0755);
+            *p = '/';
+        }
+    }
+    mkdir(path, 0755);
+}
+
+static GLuint load_binary(const char *path, uint64_t key)
+{
+    FILE *fp = fopen(path, "rb");
+    if (!fp)
+        return 0;
+
+    struct program_cache_header hdr;
+    void *binary = NULL;
+    GLuint program = 0;
+
+    if (fread(&hdr, sizeof(hdr), 1, fp) != 1 || hdr.magic != PROGRAM_CACHE_MAGIC ||
+        hdr.version != PROGRAM_CACHE_VERSION || hdr.key != key || hdr.length == 0)
+        goto out;
+
+    binary = malloc(hdr.length);
+    if (!binary)
+    {
+        logerror("malloc %u failed", (unsigned)hdr.length);
+        goto out;
+    }
+    if (fread(binary, 1, hdr.length, fp) != hdr.length)
+        goto out;
+
+    program = glCreateProgram();
+    glProgramBinary(program, hdr.binary_format, binary, hdr.length);
+    GLint success = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        // driver update or a binary from another GPU, rebuild and overwrite
+        pthread_mutex_lock(&lock_);
+        ++rejects_;
+        pthread_mutex_unlock(&lock_);
+        glDeleteProgram(program);
+        program = 0;
+    }
+
+out:
+    free(binary);
+    fclose(fp);
+    return program;
+}
+
+static void store_binary(const char *dir, const char *path, uint64_t key, GLuint program)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+        logwarn("program binary not retrievable");
+        return;
+    }
+
+    void *binary = malloc(length);
+    if (!binary)
+    {
+        logerror("malloc %d failed", length);
+        return;
+    }
+    GLenum binary_format;
+    glGetProgramBinary(program, length, &length, &binary_format, binary);
+
+    make_dirs(dir);
+
+    // write aside and rename so a concurrent launch or thread never reads a torn file
+    // a truncated name could collide with another writer's or be <path> itself
+    char tmp[640];
+    int len = snprintf(tmp, sizeof(tmp), "%s.%d.%u.tmp", path, (int)getpid(), __atomic_fetch_add(&tmp_seq_, 1, __ATOMIC_RELAXED));
+    if (len < 0 || (size_t)len >= sizeof(tmp))
+    {
+        logwarn("cache path %s too long", path);
+        free(binary);
+        return;
+    }
+    FILE *fp = fopen(tmp, "wb");
+    if (!fp)
+    {
+        logwarn("open %s failed", tmp);
+        free(binary);
+        return;
+    }
+
+    struct program_cache_header hdr = {
+        .magic = PROGRAM_CACHE_MAGIC,
+        .version = PROGRAM_CACHE_VERSION,
+        .key = key,
+        .binary_format = binary_format,
+        .length = length,
+    };
+    int ok = fwrite(&hdr, sizeof(hdr), 1, fp) == 1 && fwrite(binary, 1, length, fp) == (size_t)length;
+    ok = fclose(fp) == 0 && ok;
+    if (!ok || rename(tmp, path) != 0)
+    {
+        logwarn("write %s failed", path);
+        unlink(tmp);
+    }
+
+    free(binary);
+}
+
+static void count_build(size_t *count, double *total_ms, double ms)
+{
+    pthread_mutex_lock(&lock_);
+    ++*count;
+    *total_ms += ms;
+    pthread_mutex_unlock(&lock_);
+}
+
+GLuint program_cache_build(const char *vertex_shader_src, const char *fragment_shader_src, program_build_func build)
+{
+    const char *dir = cache_dir();
+
+    GLint num_formats = 0;
+    if (dir)
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+
+    if (!dir || num_formats <= 0)
+    {
+        double start = now_ms();
+        GLuint program = build(vertex_shader_src, fragment_shader_src);
+        count_build(&misses_, &compile_ms_, now_ms() - start);
+        return program;
+    }
+
+    uint64_t key = 0xcbf29ce484222325ULL;
+    key = hash_string(key, vertex_shader_src);
+    key = hash_string(key, fragment_shader_src);
+    key = hash_string(key, (const char *)glGetString(GL_RENDERER));
+    key = hash_string(key, (const char *)glGetString(GL_VERSION));
+
+    char path[600];
+    int len = snprintf(path, sizeof(path), "%s/%016llx.bin", dir, (unsigned long long)key);
+    if (len < 0 || (size_t)len >= sizeof(path))
+    {
+        // a truncated name would load or overwrite another program's binary
+        logwarn("cache dir %s too long, building without the cache", dir);
+        path[0] = '\0';
+    }
+
+    double start = now_ms();
+    GLuint program = path[0] ? load_binary(path, key) : 0;
+    if (program)
+    {
+        count_build(&hits_, &load_ms_, now_ms() - start);
+        return program;
+    }
+
+    start = now_ms();
+    program = build(vertex_shader_src, fragment_shader_src);
+    count_build(&misses_, &compile_ms_, now_ms() - start);
+    if (program && path[0])
+        store_binary(dir, path, key, program);
+
+    return program;
+}
+
+void set_program_cache_dir(const char *dir)
+{
+    pthread_mutex_lock(&lock_);
+    dir_init_ = 1;
+    disabled_ = dir == NULL;
+    if (dir)
+        snprintf(dir_, sizeof(dir_), "%s", dir);
+    pthread_mutex_unlock(&lock_);
+}
+
+void program_cache_report()
+{
+    loginfo("program cache %s: %zu hits (%.2f ms load), %zu misses (%.2f ms compile), %zu rejected",
+        cache_dir() ? cache_dir() : "disabled", hits_, load_ms_, misses_, compile_ms_, rejects_);
+}
@@ -0,0 +1,27 @@
+#ifndef PROGRAM_CACHE_H__
+#define PROGRAM_CACHE_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#include <GLES3/gl3.h>
+
+    // compile and link from source, return 0 on failure
+    typedef GLuint (*program_build_func)(const char *vertex_shader_src, const char *fragment_shader_src);
+
+    // look the program up in the on-disk cache, keyed by both sources plus GL_RENDERER and GL_VERSION;
+    // on a miss or a binary the driver rejects, build it and store the binary for the next launch
+    GLuint program_cache_build(const char *vertex_shader_src, const char *fragment_shader_src, program_build_func build);
+
+    // override the cache directory ($PROGRAM_CACHE_DIR, else ~/.cache/opengles-test), NULL disables the cache
+    void set_program_cache_dir(const char *dir);
+
+    // log hit/miss counts and the time spent compiling vs loading
+    void program_cache_report();
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // PROGRAM_CACHE_H__
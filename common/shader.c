@@ -0,0 +1,134 @@
+#include <stdlib.h>
+#include "shader.h"
+#include "log.h"
+#include "program_cache.h"
+
+static int check_error(GLuint x)
+{
+    void (*glGetiv)(GLuint x, GLenum pname, GLint *params);
+    void (*glGetInfoLog)(GLuint x, GLsizei bufSize, GLsizei *length, GLchar *infoLog);
+    void (*glDelete)(GLuint x);
+    GLenum pname_status;
+
+    if (glIsShader(x))
+    {
+        glGetiv = glGetShaderiv;
+        glGetInfoLog = glGetShaderInfoLog;
+        glDelete = glDeleteShader;
+        pname_status = GL_COMPILE_STATUS;
+    }
+    else if (glIsProgram(x))
+    {
+        glGetiv = glGetProgramiv;
+        glGetInfoLog = glGetProgramInfoLog;
+        glDelete = glDeleteProgram;
+        pname_status = GL_LINK_STATUS;
+    }
+    else
+    {
+        logerror("invalid x");
+        return -1;
+    }
+
+    GLint success;
+    glGetiv(x, pname_status, &success);
+    if (!success)
+    {
+        GLint info_len = 0;
+        glGetiv(x, GL_INFO_LOG_LENGTH, &info_len);
+        if (info_len > 1)
+        {
+            char *info_log = calloc(1, info_len);
+            glGetInfoLog(x, info_len, NULL, info_log);
+            logerror("failed: %s", info_log);
+            free(info_log);
+        }
+        glDelete(x);
+        return -1;
+    }
+
+    return 0;
+}
+
+GLuint load_shader(GLenum type, const char *shader_src)
+{
+    GLuint shader = glCreateShader(type);
+    if (shader == 0)
+    {
+        logerror("glCreateShader failed");
+        return 0;
+    }
+
+    // load the shader source
+    glShaderSource(shader, 1, &shader_src, NULL);
+
+    // compile the shader
+    glCompileShader(shader);
+
+    if (check_error(shader) != 0)
+    {
+        logerror("error accured");
+        return 0;
+    }
+
+    return shader;
+}
+
+GLuint link_program(GLuint vertex_shader, GLuint fragment_shader)
+{
+    GLuint program = glCreateProgram();
+    if (program == 0)
+    {
+        logerror("glCreateProgram failed");
+        return 0;
+    }
+
+    glAttachShader(program, vertex_shader);
+    glAttachShader(program, fragment_shader);
+
+    // some drivers only keep a binary for glGetProgramBinary when asked before linking
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(program);
+
+    if (check_error(program) != 0)
+    {
+        logerror("error occured");
+        return 0;
+    }
+
+    return program;
+}
+
+GLuint build_program(const char *vertex_shader_src, const char *fragment_shader_src)
+{
+    GLuint vertex_shader = load_shader(GL_VERTEX_SHADER, vertex_shader_src);
+    if (vertex_shader == 0)
+    {
+        logerror("load_shader VERTEX failed");
+        return 0;
+    }
+
+    GLuint fragment_shader = load_shader(GL_FRAGMENT_SHADER, fragment_shader_src);
+    if (fragment_shader == 0)
+    {
+        logerror("load_shader FRAGMENT failed");
+        glDeleteShader(vertex_shader);
+        return 0;
+    }
+
+    GLuint program = link_program(vertex_shader, fragment_shader);
+
+    // the program keeps what it needs
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+
+    if (program == 0)
+        logerror("link_program failed");
+
+    return program;
+}
+
+GLuint create_program(const char *vertex_shader_src, const char *fragment_shader_src)
+{
+    return program_cache_build(vertex_shader_src, fragment_shader_src, build_program);
+}
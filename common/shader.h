@@ -0,0 +1,25 @@
+#ifndef SHADER_H__
+#define SHADER_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#include <GLES3/gl3.h>
+
+    // compile one stage, 0 on failure with the info log logged
+    GLuint load_shader(GLenum type, const char *shader_src);
+
+    GLuint link_program(GLuint vertex_shader, GLuint fragment_shader);
+
+    // load_shader + link_program, the shaders are deleted once linked
+    GLuint build_program(const char *vertex_shader_src, const char *fragment_shader_src);
+
+    // build_program, served from the program binary cache when possible
+    GLuint create_program(const char *vertex_shader_src, const char *fragment_shader_src);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // SHADER_H__
@@ -0,0 +1,162 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "thread_pool.h"
+#include "log.h"
+
+struct thread_pool
+{
+    int threads; // including the caller
+    pthread_t workers[THREAD_POOL_MAX_THREADS];
+    int started;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t cond_job;  // workers: a new generation or stop
+    pthread_cond_t cond_done; // caller: pending reached 0
+    unsigned generation;
+    int pending;
+    int stop;
+
+    thread_pool_fn fn;
+    void *arg;
+    int count;
+};
+
+struct worker_arg
+{
+    struct thread_pool *pool;
+    int index;
+};
+
+static void run_band(struct thread_pool *pool, int index)
+{
+    // bands differ by at most one, the first <count % threads> get the extra item
+    int base = pool->count / pool->threads;
+    int extra = pool->count % pool->threads;
+    int begin = index * base + (index < extra ? index : extra);
+    int end = begin + base + (index < extra);
+    if (begin < end)
+        pool->fn(pool->arg, begin, end);
+}
+
+static void *worker_thread(void *p)
+{
+    struct worker_arg *wa = p;
+    struct thread_pool *pool = wa->pool;
+    int index = wa->index;
+    free(wa);
+
+    unsigned seen = 0;
+    pthread_mutex_lock(&pool->mutex);
+    for (;;)
+    {
+        while (!pool->stop && pool->generation == seen)
+            pthread_cond_wait(&pool->cond_job, &pool->mutex);
+        if (pool->stop)
+            break;
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->mutex);
+
+        run_band(pool, index);
+
+        pthread_mutex_lock(&pool->mutex);
+        if (--pool->pending == 0)
+            pthread_cond_signal(&pool->cond_done);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    return NULL;
+}
+
+struct thread_pool *thread_pool_create(int threads)
+{
+    if (threads <= 0)
+        threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads <= 0)
+        threads = 1;
+    if (threads > THREAD_POOL_MAX_THREADS)
+        threads = THREAD_POOL_MAX_THREADS;
+
+    struct thread_pool *pool = calloc(1, sizeof(*pool));
+    if (!pool)
+    {
+        logerror("calloc failed");
+        return NULL;
+    }
+    pool->threads = threads;
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->cond_job, NULL);
+    pthread_cond_init(&pool->cond_done, NULL);
+
+    // worker i runs band i, band 0 belongs to the caller
+    for (int i = 1; i < threads; ++i)
+    {
+        struct worker_arg *wa = malloc(sizeof(*wa));
+        if (!wa)
+        {
+            logerror("malloc failed");
+            thread_pool_destroy(pool);
+            return NULL;
+        }
+        wa->pool = pool;
+        wa->index = i;
+        if (pthread_create(&pool->workers[i], NULL, worker_thread, wa) != 0)
+        {
+            logerror("pthread_create failed");
+            free(wa);
+            thread_pool_destroy(pool);
+            return NULL;
+        }
+        pool->started = i;
+    }
+
+    return pool;
+}
+
+int thread_pool_threads(struct thread_pool *pool)
+{
+    return pool->threads;
+}
+
+void thread_pool_run(struct thread_pool *pool, thread_pool_fn fn, void *arg, int count)
+{
+    pool->fn = fn;
+    pool->arg = arg;
+    pool->count = count;
+    if (pool->threads == 1)
+    {
+        run_band(pool, 0);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->pending = pool->threads - 1;
+    ++pool->generation;
+    pthread_cond_broadcast(&pool->cond_job);
+    pthread_mutex_unlock(&pool->mutex);
+
+    run_band(pool, 0);
+
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->pending > 0)
+        pthread_cond_wait(&pool->cond_done, &pool->mutex);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+void thread_pool_destroy(struct thread_pool *pool)
+{
+    if (!pool)
+        return;
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->cond_job);
+    pthread_mutex_unlock(&pool->mutex);
+    for (int i = 1; i <= pool->started; ++i)
+        pthread_join(pool->workers[i], NULL);
+
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->cond_job);
+    pthread_cond_destroy(&pool->cond_done);
+    free(pool);
+}
@@ -0,0 +1,32 @@
+#ifndef THREAD_POOL_H__
+#define THREAD_POOL_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#define THREAD_POOL_MAX_THREADS 64
+
+    // called once per band with a disjoint [begin, end) of the job's range
+    typedef void (*thread_pool_fn)(void *arg, int begin, int end);
+
+    struct thread_pool;
+
+    // <threads> workers including the caller (0: one per online CPU), so 1 runs inline
+    struct thread_pool *thread_pool_create(int threads);
+
+    int thread_pool_threads(struct thread_pool *pool);
+
+    // split [0, count) into one contiguous band per thread and run <fn> on all of them,
+    // the caller takes the first band and returns when every band is done;
+    // one job at a time, from one thread
+    void thread_pool_run(struct thread_pool *pool, thread_pool_fn fn, void *arg, int count);
+
+    // NULL-safe
+    void thread_pool_destroy(struct thread_pool *pool);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // THREAD_POOL_H__
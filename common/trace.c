@@ -0,0 +1,182 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <sys/syscall.h>
+#include "trace.h"
+#include "log.h"
+
+#define TRACE_DEFAULT_EVENTS 65536
+#define TRACE_NAME_SIZE 32
+
+struct trace_event
+{
+    const char *name;
+    uint64_t begin_ns;
+    uint64_t dur_ns;
+};
+
+// written only by its thread, read by trace_write; a ring of the last <capacity> spans
+struct trace_buffer
+{
+    _Atomic size_t count;
+    int tid;
+    char name[TRACE_NAME_SIZE];
+    struct trace_buffer *next;
+    struct trace_event events[];
+};
+
+int trace_enabled_;
+
+static char *path_;
+static size_t capacity_;
+static uint64_t start_ns_;
+static struct trace_buffer *_Atomic buffers_;
+static __thread struct trace_buffer *buffer_;
+
+uint64_t trace_begin()
+{
+    struct timespec tp;
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return (uint64_t)tp.tv_sec * 1000000000 + tp.tv_nsec;
+}
+
+static struct trace_buffer *get_buffer()
+{
+    if (buffer_)
+        return buffer_;
+
+    struct trace_buffer *buf = calloc(1, sizeof(*buf) + capacity_ * sizeof(struct trace_event));
+    if (!buf)
+        return NULL;
+    buf->tid = syscall(SYS_gettid);
+    snprintf(buf->name, sizeof(buf->name), "thread %d", buf->tid);
+
+    buf->next = atomic_load(&buffers_);
+    while (!atomic_compare_exchange_weak(&buffers_, &buf->next, buf))
+        ;
+
+    buffer_ = buf;
+    return buf;
+}
+
+int trace_init(const char *path, size_t max_events)
+{
+    if (!path)
+        path = getenv("TRACE_FILE");
+    if (!path || !path[0])
+        return 0;
+
+    path_ = strdup(path);
+    if (!path_)
+        return -1;
+    capacity_ = max_events > 0 ? max_events : TRACE_DEFAULT_EVENTS;
+    start_ns_ = trace_begin();
+    trace_enabled_ = 1;
+    loginfo("trace: recording to %s", path_);
+
+    return 0;
+}
+
+void trace_thread_name(const char *name)
+{
+    if (!trace_enabled_)
+        return;
+
+    struct trace_buffer *buf = get_buffer();
+    if (buf)
+        snprintf(buf->name, sizeof(buf->name), "%s", name);
+}
+
+void trace_end(const char *name, uint64_t begin_ns)
+{
+    struct trace_buffer *buf = get_buffer();
+    if (!buf)
+        return;
+
+    size_t count = atomic_load_explicit(&buf->count, memory_order_relaxed);
+    struct trace_event *ev = &buf->events[count % capacity_];
+    ev->name = name;
+    ev->begin_ns = begin_ns;
+    ev->dur_ns = trace_begin() - begin_ns;
+    atomic_store_explicit(&buf->count, count + 1, memory_order_release);
+}
+
+static void write_buffer(FILE *fp, const struct trace_buffer *buf, int pid, int *first)
+{
+    fprintf(fp, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+        *first ? "" : ",", pid, buf->tid, buf->name);
+    *first = 0;
+
+    // only published spans are read; the oldest slot is skipped once the ring
+    // wrapped, the owning thread may be overwriting it right now
+    size_t count = atomic_load_explicit(&buf->count, memory_order_acquire);
+    size_t begin = count >= capacity_ ? count - capacity_ + 1 : 0;
+    for (size_t i = begin; i < count; i++)
+    {
+        const struct trace_event *ev = &buf->events[i % capacity_];
+        if (ev->begin_ns < start_ns_)
+            continue;
+        fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+            ev->name, pid, buf->tid, (ev->begin_ns - start_ns_) / 1e3, ev->dur_ns / 1e3);
+    }
+}
+
+int trace_write()
+{
+    if (!trace_enabled_)
+        return 0;
+
+    char tmp_path[4096];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path_);
+    FILE *fp = fopen(tmp_path, "w");
+    if (!fp)
+    {
+        logerror("trace: fopen %s failed", tmp_path);
+        return -1;
+    }
+
+    int pid = getpid();
+    int first = 1;
+    size_t events = 0;
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (struct trace_buffer *buf = atomic_load(&buffers_); buf; buf = buf->next)
+    {
+        write_buffer(fp, buf, pid, &first);
+        size_t count = atomic_load(&buf->count);
+        events += count < capacity_ ? count : capacity_;
+    }
+    fprintf(fp, "\n]}\n");
+
+    if (fclose(fp) != 0 || rename(tmp_path, path_) != 0)
+    {
+        logerror("trace: write %s failed", path_);
+        remove(tmp_path);
+        return -1;
+    }
+    loginfo("trace: %zu events written to %s", events, path_);
+
+    return 0;
+}
+
+void trace_destroy()
+{
+    if (!trace_enabled_)
+        return;
+
+    trace_write();
+    trace_enabled_ = 0;
+
+    struct trace_buffer *buf = atomic_exchange(&buffers_, NULL);
+    while (buf)
+    {
+        struct trace_buffer *next = buf->next;
+        free(buf);
+        buf = next;
+    }
+    buffer_ = NULL;
+    free(path_);
+    path_ = NULL;
+}
@@ -0,0 +1,66 @@
+#ifndef TRACE_H__
+#define TRACE_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#include <stddef.h>
+#include <stdint.h>
+
+    // read by the TRACE_* macros, so a disabled recorder costs one branch
+    extern int trace_enabled_;
+
+    // record into per-thread rings of <max_events> (0: default 65536) and write
+    // Chrome trace-event JSON to <path> (NULL: $TRACE_FILE, unset: stay disabled)
+    int trace_init(const char *path, size_t max_events);
+
+    // name the calling thread's track
+    void trace_thread_name(const char *name);
+
+    uint64_t trace_begin();
+    // <name> must be a string literal or otherwise outlive the recorder
+    void trace_end(const char *name, uint64_t begin_ns);
+
+    // serialise everything recorded so far, keeps recording
+    int trace_write();
+
+    // write and free the buffers, every other recording thread must be joined
+    void trace_destroy();
+
+    struct trace_scope
+    {
+        const char *name;
+        uint64_t begin_ns;
+    };
+
+    static inline void trace_scope_end_(struct trace_scope *scope)
+    {
+        if (scope->begin_ns)
+            trace_end(scope->name, scope->begin_ns);
+    }
+
+#define TRACE_CONCAT2_(a, b) a##b
+#define TRACE_CONCAT_(a, b) TRACE_CONCAT2_(a, b)
+
+// span from here to the end of the enclosing block
+#define TRACE_SCOPE(name)                                              \
+    struct trace_scope TRACE_CONCAT_(trace_scope_, __LINE__)           \
+        __attribute__((cleanup(trace_scope_end_))) = {                 \
+            name, trace_enabled_ ? trace_begin() : 0}
+
+// explicit begin/end when the span does not match a block
+#define TRACE_BEGIN(var) uint64_t var = trace_enabled_ ? trace_begin() : 0
+#define TRACE_END(name, var)       \
+    do                             \
+    {                              \
+        if (var)                   \
+            trace_end(name, var);  \
+    }                              \
+    while (0)
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // TRACE_H__
@@ -0,0 +1,330 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cpu_convert.h"
+#include "thread_pool.h"
+#include "trace.h"
+#include "log.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_CONVERT_X86
+#include <immintrin.h>
+#endif
+#if defined(__aarch64__)
+#define CPU_CONVERT_NEON
+#include <arm_neon.h>
+#endif
+
+// nv24.c's mat3 in the 8-bit domain: rgb = y + k * (c - 127.5), with c - 127.5 taken
+// as (2c - 255) / 2 so it stays integer; k * 32768 rounded gives Q16 products,
+// (sum + 0.5) >> 16 matches the round to nearest of the unorm8 render target
+#define K_RV 37351 // 1.13983
+#define K_GU 12932 // 0.39465
+#define K_GV 19025 // 0.58060
+#define K_BU 66587 // 2.03211
+#define K_ROUND 32768
+
+// convert pixels [x, width) of one row
+typedef void (*nv24_row_fn)(const uint8_t *y, const uint8_t *uv, uint8_t *rgb, int x, int width);
+
+struct cpu_converter
+{
+    int width;
+    int height;
+    nv24_row_fn row;
+    struct thread_pool *pool;
+    const uint8_t *src;
+    uint8_t *dst;
+};
+
+static const char *isa_names_[CPU_ISA_COUNT] = {"scalar", "sse4.1", "avx2", "neon"};
+
+static inline uint8_t clamp_u8(int x)
+{
+    return x < 0 ? 0 : x > 255 ? 255 : x;
+}
+
+// the reference every vector kernel is checked against
+static void nv24_row_scalar(const uint8_t *y, const uint8_t *uv, uint8_t *rgb, int x, int width)
+{
+    for (; x < width; ++x)
+    {
+        int yy = (y[x] << 16) + K_ROUND;
+        int du = 2 * uv[2 * x] - 255;
+        int dv = 2 * uv[2 * x + 1] - 255;
+        // >> of a negative int is arithmetic on every compiler this builds with
+        rgb[3 * x] = clamp_u8((yy + K_RV * dv) >> 16);
+        rgb[3 * x + 1] = clamp_u8((yy - K_GU * du - K_GV * dv) >> 16);
+        rgb[3 * x + 2] = clamp_u8((yy + K_BU * du) >> 16);
+    }
+}
+
+#ifdef CPU_CONVERT_X86
+
+// 4 pixels in 32-bit lanes, from the low 4 bytes of y8 / u8 / v8
+__attribute__((target("sse4.1"))) static inline void yuv4_sse41(__m128i y8, __m128i u8, __m128i v8,
+    __m128i *r, __m128i *g, __m128i *b)
+{
+    const __m128i bias = _mm_set1_epi32(255);
+    __m128i yy = _mm_add_epi32(_mm_slli_epi32(_mm_cvtepu8_epi32(y8), 16), _mm_set1_epi32(K_ROUND));
+    __m128i du = _mm_sub_epi32(_mm_slli_epi32(_mm_cvtepu8_epi32(u8), 1), bias);
+    __m128i dv = _mm_sub_epi32(_mm_slli_epi32(_mm_cvtepu8_epi32(v8), 1), bias);
+    *r = _mm_srai_epi32(_mm_add_epi32(yy, _mm_mullo_epi32(dv, _mm_set1_epi32(K_RV))), 16);
+    *g = _mm_srai_epi32(_mm_sub_epi32(_mm_sub_epi32(yy, _mm_mullo_epi32(du, _mm_set1_epi32(K_GU))),
+                            _mm_mullo_epi32(dv, _mm_set1_epi32(K_GV))),
+        16);
+    *b = _mm_srai_epi32(_mm_add_epi32(yy, _mm_mullo_epi32(du, _mm_set1_epi32(K_BU))), 16);
+}
+
+// 16 pixels of planar r / g / b bytes to 48 bytes of rgb24
+__attribute__((target("sse4.1"))) static inline void store_rgb_sse41(uint8_t *dst, __m128i r, __m128i g, __m128i b)
+{
+    __m128i out0 = _mm_or_si128(_mm_or_si128(
+                                    _mm_shuffle_epi8(r, _mm_setr_epi8(0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1, 5)),
+                                    _mm_shuffle_epi8(g, _mm_setr_epi8(-1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1))),
+        _mm_shuffle_epi8(b, _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1)));
+    __m128i out1 = _mm_or_si128(_mm_or_si128(
+                                    _mm_shuffle_epi8(r, _mm_setr_epi8(-1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10, -1)),
+                                    _mm_shuffle_epi8(g, _mm_setr_epi8(5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10))),
+        _mm_shuffle_epi8(b, _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1)));
+    __m128i out2 = _mm_or_si128(_mm_or_si128(
+                                    _mm_shuffle_epi8(r, _mm_setr_epi8(-1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1)),
+                                    _mm_shuffle_epi8(g, _mm_setr_epi8(-1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1))),
+        _mm_shuffle_epi8(b, _mm_setr_epi8(10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15)));
+    _mm_storeu_si128((__m128i *)dst, out0);
+    _mm_storeu_si128((__m128i *)(dst + 16), out1);
+    _mm_storeu_si128((__m128i *)(dst + 32), out2);
+}
+
+// 16 interleaved UV pairs to 16 U and 16 V bytes
+__attribute__((target("sse4.1"))) static inline void load_uv_sse41(const uint8_t *uv, __m128i *u8, __m128i *v8)
+{
+    const __m128i mask = _mm_set1_epi16(0x00ff);
+    __m128i uv0 = _mm_loadu_si128((const __m128i *)uv);
+    __m128i uv1 = _mm_loadu_si128((const __m128i *)(uv + 16));
+    *u8 = _mm_packus_epi16(_mm_and_si128(uv0, mask), _mm_and_si128(uv1, mask));
+    *v8 = _mm_packus_epi16(_mm_srli_epi16(uv0, 8), _mm_srli_epi16(uv1, 8));
+}
+
+__attribute__((target("sse4.1"))) static void nv24_row_sse41(const uint8_t *y, const uint8_t *uv, uint8_t *rgb, int x, int width)
+{
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i y8 = _mm_loadu_si128((const __m128i *)(y + x));
+        __m128i u8, v8;
+        load_uv_sse41(uv + 2 * x, &u8, &v8);
+
+        __m128i r[4], g[4], b[4];
+        yuv4_sse41(y8, u8, v8, &r[0], &g[0], &b[0]);
+        yuv4_sse41(_mm_srli_si128(y8, 4), _mm_srli_si128(u8, 4), _mm_srli_si128(v8, 4), &r[1], &g[1], &b[1]);
+        yuv4_sse41(_mm_srli_si128(y8, 8), _mm_srli_si128(u8, 8), _mm_srli_si128(v8, 8), &r[2], &g[2], &b[2]);
+        yuv4_sse41(_mm_srli_si128(y8, 12), _mm_srli_si128(u8, 12), _mm_srli_si128(v8, 12), &r[3], &g[3], &b[3]);
+
+        // saturating packs are the clamp to [0, 255]
+        store_rgb_sse41(rgb + 3 * x,
+            _mm_packus_epi16(_mm_packs_epi32(r[0], r[1]), _mm_packs_epi32(r[2], r[3])),
+            _mm_packus_epi16(_mm_packs_epi32(g[0], g[1]), _mm_packs_epi32(g[2], g[3])),
+            _mm_packus_epi16(_mm_packs_epi32(b[0], b[1]), _mm_packs_epi32(b[2], b[3])));
+    }
+    nv24_row_scalar(y, uv, rgb, x, width);
+}
+
+// 8 pixels in 32-bit lanes, from the low 8 bytes of y8 / u8 / v8
+__attribute__((target("avx2"))) static inline void yuv8_avx2(__m128i y8, __m128i u8, __m128i v8,
+    __m256i *r, __m256i *g, __m256i *b)
+{
+    const __m256i bias = _mm256_set1_epi32(255);
+    __m256i yy = _mm256_add_epi32(_mm256_slli_epi32(_mm256_cvtepu8_epi32(y8), 16), _mm256_set1_epi32(K_ROUND));
+    __m256i du = _mm256_sub_epi32(_mm256_slli_epi32(_mm256_cvtepu8_epi32(u8), 1), bias);
+    __m256i dv = _mm256_sub_epi32(_mm256_slli_epi32(_mm256_cvtepu8_epi32(v8), 1), bias);
+    *r = _mm256_srai_epi32(_mm256_add_epi32(yy, _mm256_mullo_epi32(dv, _mm256_set1_epi32(K_RV))), 16);
+    *g = _mm256_srai_epi32(_mm256_sub_epi32(_mm256_sub_epi32(yy, _mm256_mullo_epi32(du, _mm256_set1_epi32(K_GU))),
+                               _mm256_mullo_epi32(dv, _mm256_set1_epi32(K_GV))),
+        16);
+    *b = _mm256_srai_epi32(_mm256_add_epi32(yy, _mm256_mullo_epi32(du, _mm256_set1_epi32(K_BU))), 16);
+}
+
+// two vectors of 8 int32 to 16 saturated bytes in order
+__attribute__((target("avx2"))) static inline __m128i pack_u8_avx2(__m256i lo, __m256i hi)
+{
+    // packs works per 128-bit lane, the permute puts the quadwords back in pixel order
+    __m256i p = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xd8);
+    return _mm_packus_epi16(_mm256_castsi256_si128(p), _mm256_extracti128_si256(p, 1));
+}
+
+__attribute__((target("avx2"))) static void nv24_row_avx2(const uint8_t *y, const uint8_t *uv, uint8_t *rgb, int x, int width)
+{
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i y8 = _mm_loadu_si128((const __m128i *)(y + x));
+        __m128i u8, v8;
+        load_uv_sse41(uv + 2 * x, &u8, &v8);
+
+        __m256i r[2], g[2], b[2];
+        yuv8_avx2(y8, u8, v8, &r[0], &g[0], &b[0]);
+        yuv8_avx2(_mm_srli_si128(y8, 8), _mm_srli_si128(u8, 8), _mm_srli_si128(v8, 8), &r[1], &g[1], &b[1]);
+
+        store_rgb_sse41(rgb + 3 * x, pack_u8_avx2(r[0], r[1]), pack_u8_avx2(g[0], g[1]), pack_u8_avx2(b[0], b[1]));
+    }
+    nv24_row_scalar(y, uv, rgb, x, width);
+}
+
+#endif // CPU_CONVERT_X86
+
+#ifdef CPU_CONVERT_NEON
+
+// 8 pixels, saturated to int16 lanes
+static inline void yuv8_neon(uint8x8_t y8, uint8x8_t u8, uint8x8_t v8, int16x8_t *r, int16x8_t *g, int16x8_t *b)
+{
+    uint16x8_t y16 = vmovl_u8(y8);
+    int16x8_t du = vsubq_s16(vreinterpretq_s16_u16(vshll_n_u8(u8, 1)), vdupq_n_s16(255));
+    int16x8_t dv = vsubq_s16(vreinterpretq_s16_u16(vshll_n_u8(v8, 1)), vdupq_n_s16(255));
+
+    int32x4_t yy_lo = vreinterpretq_s32_u32(vshll_n_u16(vget_low_u16(y16), 16));
+    int32x4_t yy_hi = vreinterpretq_s32_u32(vshll_n_u16(vget_high_u16(y16), 16));
+    int32x4_t du_lo = vmovl_s16(vget_low_s16(du)), du_hi = vmovl_s16(vget_high_s16(du));
+    int32x4_t dv_lo = vmovl_s16(vget_low_s16(dv)), dv_hi = vmovl_s16(vget_high_s16(dv));
+
+    // vrshrq_n_s32(x, 16) is (x + 32768) >> 16, the K_ROUND of the scalar kernel
+    *r = vcombine_s16(vqmovn_s32(vrshrq_n_s32(vmlaq_n_s32(yy_lo, dv_lo, K_RV), 16)),
+        vqmovn_s32(vrshrq_n_s32(vmlaq_n_s32(yy_hi, dv_hi, K_RV), 16)));
+    *g = vcombine_s16(vqmovn_s32(vrshrq_n_s32(vmlsq_n_s32(vmlsq_n_s32(yy_lo, du_lo, K_GU), dv_lo, K_GV), 16)),
+        vqmovn_s32(vrshrq_n_s32(vmlsq_n_s32(vmlsq_n_s32(yy_hi, du_hi, K_GU), dv_hi, K_GV), 16)));
+    *b = vcombine_s16(vqmovn_s32(vrshrq_n_s32(vmlaq_n_s32(yy_lo, du_lo, K_BU), 16)),
+        vqmovn_s32(vrshrq_n_s32(vmlaq_n_s32(yy_hi, du_hi, K_BU), 16)));
+}
+
+static void nv24_row_neon(const uint8_t *y, const uint8_t *uv, uint8_t *rgb, int x, int width)
+{
+    for (; x + 16 <= width; x += 16)
+    {
+        uint8x16_t y8 = vld1q_u8(y + x);
+        uint8x16x2_t uv8 = vld2q_u8(uv + 2 * x);
+
+        int16x8_t r[2], g[2], b[2];
+        yuv8_neon(vget_low_u8(y8), vget_low_u8(uv8.val[0]), vget_low_u8(uv8.val[1]), &r[0], &g[0], &b[0]);
+        yuv8_neon(vget_high_u8(y8), vget_high_u8(uv8.val[0]), vget_high_u8(uv8.val[1]), &r[1], &g[1], &b[1]);
+
+        uint8x16x3_t out;
+        out.val[0] = vcombine_u8(vqmovun_s16(r[0]), vqmovun_s16(r[1]));
+        out.val[1] = vcombine_u8(vqmovun_s16(g[0]), vqmovun_s16(g[1]));
+        out.val[2] = vcombine_u8(vqmovun_s16(b[0]), vqmovun_s16(b[1]));
+        vst3q_u8(rgb + 3 * x, out);
+    }
+    nv24_row_scalar(y, uv, rgb, x, width);
+}
+
+#endif // CPU_CONVERT_NEON
+
+const char *cpu_isa_name(enum cpu_isa isa)
+{
+    return isa < CPU_ISA_COUNT ? isa_names_[isa] : "unknown";
+}
+
+enum cpu_isa cpu_isa_find(const char *name)
+{
+    for (int i = 0; i < CPU_ISA_COUNT; ++i)
+    {
+        if (strcmp(isa_names_[i], name) == 0)
+            return i;
+    }
+    return CPU_ISA_COUNT;
+}
+
+int cpu_isa_supported(enum cpu_isa isa)
+{
+    switch (isa)
+    {
+    case CPU_ISA_SCALAR: return 1;
+#ifdef CPU_CONVERT_X86
+    case CPU_ISA_SSE41: return __builtin_cpu_supports("sse4.1");
+    case CPU_ISA_AVX2: return __builtin_cpu_supports("avx2");
+#endif
+#ifdef CPU_CONVERT_NEON
+    case CPU_ISA_NEON: return 1;
+#endif
+    default: return 0;
+    }
+}
+
+enum cpu_isa cpu_isa_best()
+{
+    for (int i = CPU_ISA_COUNT - 1; i > CPU_ISA_SCALAR; --i)
+    {
+        if (cpu_isa_supported(i))
+            return i;
+    }
+    return CPU_ISA_SCALAR;
+}
+
+static nv24_row_fn row_kernel(enum cpu_isa isa)
+{
+    switch (isa)
+    {
+#ifdef CPU_CONVERT_X86
+    case CPU_ISA_SSE41: return nv24_row_sse41;
+    case CPU_ISA_AVX2: return nv24_row_avx2;
+#endif
+#ifdef CPU_CONVERT_NEON
+    case CPU_ISA_NEON: return nv24_row_neon;
+#endif
+    default: return nv24_row_scalar;
+    }
+}
+
+struct cpu_converter *cpu_converter_create(int width, int height, enum cpu_isa isa, int threads)
+{
+    if (!cpu_isa_supported(isa))
+    {
+        logerror("%s kernel not supported here", cpu_isa_name(isa));
+        return NULL;
+    }
+
+    struct cpu_converter *conv = calloc(1, sizeof(*conv));
+    if (!conv)
+    {
+        logerror("calloc failed");
+        return NULL;
+    }
+    conv->width = width;
+    conv->height = height;
+    conv->row = row_kernel(isa);
+    conv->pool = thread_pool_create(threads);
+    if (!conv->pool)
+    {
+        logerror("thread_pool_create failed");
+        free(conv);
+        return NULL;
+    }
+    logdebug("cpu converter %dx%d: %s, %d threads", width, height, cpu_isa_name(isa), thread_pool_threads(conv->pool));
+
+    return conv;
+}
+
+static void convert_band(void *arg, int begin, int end)
+{
+    TRACE_SCOPE("cpu_convert_band");
+    struct cpu_converter *conv = arg;
+    size_t w = conv->width;
+    const uint8_t *y_plane = conv->src;
+    const uint8_t *uv_plane = conv->src + w * conv->height;
+    for (int row = begin; row < end; ++row)
+        conv->row(y_plane + row * w, uv_plane + row * w * 2, conv->dst + row * w * 3, 0, conv->width);
+}
+
+void cpu_convert_nv24(struct cpu_converter *conv, const void *nv24, void *rgb24)
+{
+    TRACE_SCOPE("cpu_convert");
+    conv->src = nv24;
+    conv->dst = rgb24;
+    thread_pool_run(conv->pool, convert_band, conv, conv->height);
+}
+
+void cpu_converter_destroy(struct cpu_converter *conv)
+{
+    if (!conv)
+        return;
+
+    thread_pool_destroy(conv->pool);
+    free(conv);
+}
@@ -0,0 +1,47 @@
+#ifndef CPU_CONVERT_H__
+#define CPU_CONVERT_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+    // row kernels of the converter, every one bit-exact with CPU_ISA_SCALAR
+    enum cpu_isa
+    {
+        CPU_ISA_SCALAR,
+        CPU_ISA_SSE41,
+        CPU_ISA_AVX2,
+        CPU_ISA_NEON,
+        CPU_ISA_COUNT,
+    };
+
+    // "scalar", "sse4.1", "avx2", "neon"
+    const char *cpu_isa_name(enum cpu_isa isa);
+
+    // CPU_ISA_COUNT for an unknown name
+    enum cpu_isa cpu_isa_find(const char *name);
+
+    // built into this binary and runnable on this CPU
+    int cpu_isa_supported(enum cpu_isa isa);
+
+    // fastest supported kernel
+    enum cpu_isa cpu_isa_best();
+
+    struct cpu_converter;
+
+    // NV24 (full resolution Y plane, interleaved UV plane) to packed rgb24 with the
+    // fixed point equivalent of nv24.c's shader; rows are split across <threads>
+    // (0: one per online CPU)
+    struct cpu_converter *cpu_converter_create(int width, int height, enum cpu_isa isa, int threads);
+
+    // <rgb24> holds width * height * 3 bytes, top-down like the source
+    void cpu_convert_nv24(struct cpu_converter *conv, const void *nv24, void *rgb24);
+
+    // NULL-safe
+    void cpu_converter_destroy(struct cpu_converter *conv);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // CPU_CONVERT_H__
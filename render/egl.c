@@ -0,0 +1,277 @@
+#include <string.h>
+#include "egl.h"
+#include "log.h"
+
+static EGLint get_context_render_type(EGLDisplay egl_display)
+{
+    const char *extensions = eglQueryString(egl_display, EGL_EXTENSIONS);
+    if (extensions != NULL && strstr(extensions, "EGL_KHR_create_context"))
+        return EGL_OPENGL_ES3_BIT_KHR;
+    return EGL_OPENGL_ES2_BIT;
+}
+
+static int has_extension(EGLDisplay egl_display, const char *name)
+{
+    const char *extensions = eglQueryString(egl_display, EGL_EXTENSIONS);
+    return extensions != NULL && strstr(extensions, name) != NULL;
+}
+
+static int create_context(struct egl_context *ctx, EGLint surface_type)
+{
+    // initialize EGL
+    EGLint major_version;
+    EGLint minor_version;
+    if (!eglInitialize(ctx->display, &major_version, &minor_version))
+    {
+        logerror("eglInitialize failed");
+        return -1;
+    }
+    logdebug("EGL %d.%d, vendor: %s", major_version, minor_version, eglQueryString(ctx->display, EGL_VENDOR));
+
+    EGLint num_configs = 0;
+    EGLint attrib_list[] = {
+        EGL_RED_SIZE, 5,
+        EGL_GREEN_SIZE, 6,
+        EGL_BLUE_SIZE, 5,
+        EGL_ALPHA_SIZE, EGL_DONT_CARE,
+        EGL_DEPTH_SIZE, EGL_DONT_CARE,
+        EGL_STENCIL_SIZE, EGL_DONT_CARE,
+        EGL_SAMPLE_BUFFERS, 0,
+        EGL_SURFACE_TYPE, surface_type,
+        EGL_RENDERABLE_TYPE, get_context_render_type(ctx->display),
+        EGL_NONE};
+
+    // choose config
+    if (!eglChooseConfig(ctx->display, attrib_list, &ctx->config, 1, &num_configs) || num_configs < 1)
+    {
+        logerror("eglChooseConfig failed");
+        return -1;
+    }
+
+    // create a GL context
+    EGLint context_attribs[] = {EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE};
+    ctx->context = eglCreateContext(ctx->display, ctx->config, EGL_NO_CONTEXT, context_attribs);
+    if (ctx->context == EGL_NO_CONTEXT)
+    {
+        logerror("eglCreateContext failed");
+        return -1;
+    }
+
+    return 0;
+}
+
+int egl_window_create(struct egl_context *ctx, EGLNativeDisplayType egl_native_display, EGLNativeWindowType egl_native_window)
+{
+    if (!ctx)
+    {
+        logerror("invalid egl_context");
+        return -1;
+    }
+
+    ctx->display = eglGetDisplay(egl_native_display);
+    if (ctx->display == EGL_NO_DISPLAY)
+    {
+        logerror("eglGetDisplay failed");
+        return -1;
+    }
+
+    if (create_context(ctx, EGL_WINDOW_BIT) != 0)
+        return -1;
+
+    // create a surface
+    ctx->surface = eglCreateWindowSurface(ctx->display, ctx->config, egl_native_window, NULL);
+    if (ctx->surface == EGL_NO_SURFACE)
+    {
+        logerror("eglCreateWindowSurface failed");
+        return -1;
+    }
+
+    // make context current
+    if (!eglMakeCurrent(ctx->display, ctx->surface, ctx->surface, ctx->context))
+    {
+        logerror("eglMakeCurrent failed");
+        return -1;
+    }
+
+    return 0;
+}
+
+int egl_headless_create(struct egl_context *ctx, int width, int height)
+{
+    if (!ctx)
+    {
+        logerror("invalid egl_context");
+        return -1;
+    }
+
+    ctx->headless = 1;
+    ctx->width = width;
+    ctx->height = height;
+    ctx->display = EGL_NO_DISPLAY;
+
+    // prefer the Mesa surfaceless platform, it needs neither X nor a DRM master
+    if (has_extension(EGL_NO_DISPLAY, "EGL_MESA_platform_surfaceless"))
+    {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (get_platform_display)
+            ctx->display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    }
+    if (ctx->display == EGL_NO_DISPLAY)
+        ctx->display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (ctx->display == EGL_NO_DISPLAY)
+    {
+        logerror("eglGetDisplay failed");
+        return -1;
+    }
+
+    if (create_context(ctx, EGL_PBUFFER_BIT) != 0)
+        return -1;
+
+    // without EGL_KHR_surfaceless_context a (tiny) pbuffer is needed to make the context current
+    ctx->surface = EGL_NO_SURFACE;
+    if (!has_extension(ctx->display, "EGL_KHR_surfaceless_context"))
+    {
+        EGLint pbuffer_attribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+        ctx->surface = eglCreatePbufferSurface(ctx->display, ctx->config, pbuffer_attribs);
+        if (ctx->surface == EGL_NO_SURFACE)
+        {
+            logerror("eglCreatePbufferSurface failed");
+            return -1;
+        }
+    }
+
+    // make context current
+    if (!eglMakeCurrent(ctx->display, ctx->surface, ctx->surface, ctx->context))
+    {
+        logerror("eglMakeCurrent failed");
+        return -1;
+    }
+    loginfo("headless %s context, renderer: %s", ctx->surface == EGL_NO_SURFACE ? "surfaceless" : "pbuffer", glGetString(GL_RENDERER));
+
+    // offscreen render target, stays bound for the lifetime of the context
+    glGenRenderbuffers(1, &ctx->rbo);
+    glBindRenderbuffer(GL_RENDERBUFFER, ctx->rbo);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, GL_NONE);
+
+    glGenFramebuffers(1, &ctx->fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, ctx->fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, ctx->rbo);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        logerror("framebuffer incomplete");
+        return -1;
+    }
+
+    glViewport(0, 0, width, height);
+
+    return 0;
+}
+
+int egl_shared_create(struct egl_context *ctx, const struct egl_context *share)
+{
+    if (!ctx || !share)
+    {
+        logerror("invalid egl_context");
+        return -1;
+    }
+
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->display = share->display;
+    ctx->config = share->config;
+    ctx->shared = 1;
+
+    EGLint context_attribs[] = {EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE};
+    ctx->context = eglCreateContext(ctx->display, ctx->config, share->context, context_attribs);
+    if (ctx->context == EGL_NO_CONTEXT)
+    {
+        logerror("eglCreateContext (shared) failed: 0x%x", eglGetError());
+        return -1;
+    }
+
+    ctx->surface = EGL_NO_SURFACE;
+    if (!has_extension(ctx->display, "EGL_KHR_surfaceless_context"))
+    {
+        EGLint pbuffer_attribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+        ctx->surface = eglCreatePbufferSurface(ctx->display, ctx->config, pbuffer_attribs);
+        if (ctx->surface == EGL_NO_SURFACE)
+        {
+            logerror("eglCreatePbufferSurface failed");
+            eglDestroyContext(ctx->display, ctx->context);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int egl_make_current(struct egl_context *ctx)
+{
+    if (!eglMakeCurrent(ctx->display, ctx->surface, ctx->surface, ctx->context))
+    {
+        logerror("eglMakeCurrent failed: 0x%x", eglGetError());
+        return -1;
+    }
+    return 0;
+}
+
+int egl_set_swap_interval(struct egl_context *ctx, int interval)
+{
+    if (ctx->headless)
+        return 0;
+    if (!eglSwapInterval(ctx->display, interval))
+    {
+        logerror("eglSwapInterval %d failed", interval);
+        return -1;
+    }
+    return 0;
+}
+
+void egl_swap(struct egl_context *ctx)
+{
+    if (!ctx->headless)
+    {
+        eglSwapBuffers(ctx->display, ctx->surface);
+        return;
+    }
+
+    // no vsync to throttle us, so wait for the frame submitted
+    // EGL_HEADLESS_FRAMES_IN_FLIGHT frames ago before queueing another one
+    GLsync *fence = &ctx->fences[ctx->seq++ % EGL_HEADLESS_FRAMES_IN_FLIGHT];
+    if (*fence)
+    {
+        glClientWaitSync(*fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync(*fence);
+    }
+    *fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+}
+
+void egl_destroy(struct egl_context *ctx)
+{
+    if (!ctx || ctx->display == EGL_NO_DISPLAY)
+        return;
+
+    if (ctx->headless)
+    {
+        for (int i = 0; i < EGL_HEADLESS_FRAMES_IN_FLIGHT; ++i)
+        {
+            if (ctx->fences[i])
+                glDeleteSync(ctx->fences[i]);
+            ctx->fences[i] = 0;
+        }
+        glDeleteFramebuffers(1, &ctx->fbo);
+        glDeleteRenderbuffers(1, &ctx->rbo);
+    }
+
+    // a shared context may be destroyed from a thread that has another one current
+    if (!ctx->shared || eglGetCurrentContext() == ctx->context)
+        eglMakeCurrent(ctx->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (ctx->surface != EGL_NO_SURFACE)
+        eglDestroySurface(ctx->display, ctx->surface);
+    eglDestroyContext(ctx->display, ctx->context);
+    if (!ctx->shared)
+        eglTerminate(ctx->display);
+    ctx->display = EGL_NO_DISPLAY;
+}
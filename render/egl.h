@@ -0,0 +1,60 @@
+#ifndef EGL_H__
+#define EGL_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#include <GLES3/gl3.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+// frames the headless path may run ahead of the GPU before egl_swap blocks
+#define EGL_HEADLESS_FRAMES_IN_FLIGHT 2
+
+    struct egl_context
+    {
+        EGLDisplay display;
+        EGLConfig config;
+        EGLSurface surface;
+        EGLContext context;
+
+        // headless only: offscreen render target
+        int headless;
+        int width;
+        int height;
+        GLuint fbo;
+        GLuint rbo;
+        GLsync fences[EGL_HEADLESS_FRAMES_IN_FLIGHT];
+        size_t seq;
+
+        // shared only: the display belongs to the context objects are shared with
+        int shared;
+    };
+
+    int egl_window_create(struct egl_context *ctx, EGLNativeDisplayType egl_native_display, EGLNativeWindowType egl_native_window);
+
+    // surfaceless (EGL_MESA_platform_surfaceless) or pbuffer context rendering into an FBO
+    int egl_headless_create(struct egl_context *ctx, int width, int height);
+
+    // a context sharing textures, buffers and syncs with <share>, same display and config;
+    // surfaceless if EGL_KHR_surfaceless_context is there, else on a 1x1 pbuffer;
+    // not current anywhere, see egl_make_current
+    int egl_shared_create(struct egl_context *ctx, const struct egl_context *share);
+
+    // bind <ctx> to the calling thread
+    int egl_make_current(struct egl_context *ctx);
+
+    // refreshes each egl_swap waits for at least, 0 for none; no-op headless
+    int egl_set_swap_interval(struct egl_context *ctx, int interval);
+
+    // present the frame, or in headless mode bound the number of frames queued on the GPU
+    void egl_swap(struct egl_context *ctx);
+
+    void egl_destroy(struct egl_context *ctx);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // EGL_H__
@@ -0,0 +1,49 @@
+#include <string.h>
+#include "format.h"
+#include "frame_layout.h"
+#include "nv24.h"
+#include "rgb24.h"
+#include "i444.h"
+#include "nv12.h"
+#include "i420.h"
+#include "yuyv.h"
+#include "p010.h"
+#include "yuv420p10.h"
+
+// frame_layout.c lists the same names in the same order
+static const struct pixel_format formats_[] = {
+    {"nv24", nv24_init, nv24_init_shader, nv24_init_texture, nv24_update_texture, frame_size_444},
+    {"rgb24", rgb24_init, rgb24_init_shader, rgb24_init_texture, rgb24_update_texture, frame_size_444},
+    {"i444", i444_init, i444_init_shader, i444_init_texture, i444_update_texture, frame_size_444},
+    {"nv12", nv12_init, nv12_init_shader, nv12_init_texture, nv12_update_texture, frame_size_420},
+    {"nv21", nv21_init, nv12_init_shader, nv12_init_texture, nv12_update_texture, frame_size_420},
+    {"i420", i420_init, i420_init_shader, i420_init_texture, i420_update_texture, frame_size_420},
+    {"yv12", yv12_init, i420_init_shader, i420_init_texture, i420_update_texture, frame_size_420},
+    {"yuyv", yuyv_init, yuyv_init_shader, yuyv_init_texture, yuyv_update_texture, frame_size_422_packed},
+    {"uyvy", uyvy_init, yuyv_init_shader, yuyv_init_texture, yuyv_update_texture, frame_size_422_packed},
+    {"p010", p010_init, p010_init_shader, p010_init_texture, p010_update_texture, frame_size_420_16},
+    {"p016", p016_init, p010_init_shader, p010_init_texture, p010_update_texture, frame_size_420_16},
+    {"yuv420p10", yuv420p10_init, yuv420p10_init_shader, yuv420p10_init_texture, yuv420p10_update_texture, frame_size_420_16},
+};
+
+const struct pixel_format *format_find(const char *name)
+{
+    for (size_t i = 0; i < sizeof(formats_) / sizeof(formats_[0]); ++i)
+    {
+        if (strcmp(formats_[i].name, name) == 0)
+            return &formats_[i];
+    }
+    return NULL;
+}
+
+const struct pixel_format *format_at(size_t index)
+{
+    if (index >= sizeof(formats_) / sizeof(formats_[0]))
+        return NULL;
+    return &formats_[index];
+}
+
+const char *format_names()
+{
+    return frame_layout_names();
+}
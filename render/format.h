@@ -0,0 +1,55 @@
+#ifndef FORMAT_H__
+#define FORMAT_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#include <stddef.h>
+#include "util.h"
+#include "hdr.h"
+
+    // one instance of a format module, zeroed by its owner (a renderer) before init;
+    // modules keep nothing else, so any number of them may live side by side
+    struct format_state
+    {
+        int width;
+        int height;
+        int chroma_width; // subsampled planes, half the width of a packed 4:2:2 row
+        int chroma_height;
+        size_t u_offset;  // planar chroma in a frame, swapped for YV12
+        size_t v_offset;
+        int swap;         // sibling layout sharing the module: NV21 VU, UYVY
+        enum hdr_transfer transfer; // set by the owner, high bit depth modules tone map with it
+        GLuint program;
+        int texture_count;
+        GLuint textures[UPLOAD_MAX_PLANES];
+        struct upload_state *upload;
+    };
+
+    // entry points of a format module (nv24.c, rgb24.c, ...), the GL ones need the
+    // context current and leave the program and textures in <st>
+    struct pixel_format
+    {
+        const char *name;
+        void (*init)(struct format_state *st, int width, int height);
+        int (*init_shader)(struct format_state *st);
+        void (*init_texture)(struct format_state *st, void *buffer);
+        void (*update_texture)(struct format_state *st, void *buffer);
+        size_t (*frame_size)(int width, int height);
+    };
+
+    // NULL if no module registers the name
+    const struct pixel_format *format_find(const char *name);
+
+    // registered modules by index, NULL past the last one
+    const struct pixel_format *format_at(size_t index);
+
+    // comma separated list of registered names, for usage text
+    const char *format_names();
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // FORMAT_H__
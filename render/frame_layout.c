@@ -0,0 +1,64 @@
+#include <string.h>
+#include "frame_layout.h"
+
+size_t frame_size_444(int width, int height)
+{
+    return (size_t)width * height * 3;
+}
+
+size_t frame_size_420(int width, int height)
+{
+    return (size_t)width * height + (size_t)((width + 1) / 2) * ((height + 1) / 2) * 2;
+}
+
+size_t frame_size_420_16(int width, int height)
+{
+    return frame_size_420(width, height) * 2;
+}
+
+size_t frame_size_422_packed(int width, int height)
+{
+    return (size_t)((width + 1) / 2) * 4 * height;
+}
+
+// same names and order as the modules in format.c
+static const struct frame_layout layouts_[] = {
+    {"nv24", frame_size_444},
+    {"rgb24", frame_size_444},
+    {"i444", frame_size_444},
+    {"nv12", frame_size_420},
+    {"nv21", frame_size_420},
+    {"i420", frame_size_420},
+    {"yv12", frame_size_420},
+    {"yuyv", frame_size_422_packed},
+    {"uyvy", frame_size_422_packed},
+    {"p010", frame_size_420_16},
+    {"p016", frame_size_420_16},
+    {"yuv420p10", frame_size_420_16},
+};
+
+static char names_[256];
+
+const struct frame_layout *frame_layout_find(const char *name)
+{
+    for (size_t i = 0; i < sizeof(layouts_) / sizeof(layouts_[0]); ++i)
+    {
+        if (strcmp(layouts_[i].name, name) == 0)
+            return &layouts_[i];
+    }
+    return NULL;
+}
+
+const char *frame_layout_names()
+{
+    if (names_[0] == '\0')
+    {
+        for (size_t i = 0; i < sizeof(layouts_) / sizeof(layouts_[0]); ++i)
+        {
+            if (i > 0)
+                strncat(names_, ", ", sizeof(names_) - strlen(names_) - 1);
+            strncat(names_, layouts_[i].name, sizeof(names_) - strlen(names_) - 1);
+        }
+    }
+    return names_;
+}
@@ -0,0 +1,34 @@
+#ifndef FRAME_LAYOUT_H__
+#define FRAME_LAYOUT_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#include <stddef.h>
+
+    // name and size of a tightly packed frame of each format module, without any GL, for
+    // processes that only move frames around (shm_producer)
+    struct frame_layout
+    {
+        const char *name;
+        size_t (*frame_size)(int width, int height);
+    };
+
+    // NULL if no format of that name
+    const struct frame_layout *frame_layout_find(const char *name);
+
+    // comma separated list of the names, for usage text
+    const char *frame_layout_names();
+
+    // the sizes format.c hands its modules
+    size_t frame_size_444(int width, int height);
+    size_t frame_size_420(int width, int height);
+    size_t frame_size_420_16(int width, int height);
+    size_t frame_size_422_packed(int width, int height);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // FRAME_LAYOUT_H__
@@ -0,0 +1,164 @@
+#include <string.h>
+#include "glstate.h"
+#include "log.h"
+
+// ~0 never names an object, so it forces the next call through
+#define UNKNOWN ((GLuint)~0u)
+
+enum texture_target
+{
+    TARGET_2D,
+    TARGET_2D_ARRAY,
+    TARGET_COUNT,
+};
+
+enum buffer_target
+{
+    BUFFER_ARRAY,
+    BUFFER_ELEMENT_ARRAY, // part of the VAO, forgotten on every VAO change
+    BUFFER_PIXEL_PACK,
+    BUFFER_PIXEL_UNPACK,
+    BUFFER_UNIFORM,
+    BUFFER_COUNT,
+};
+
+// one shadow per thread, a thread has at most one context current
+static __thread GLuint program_ = UNKNOWN;
+static __thread GLenum active_texture_ = UNKNOWN;
+static __thread GLuint textures_[GLSTATE_MAX_UNITS][TARGET_COUNT];
+static __thread GLuint vao_ = UNKNOWN;
+static __thread GLuint buffers_[BUFFER_COUNT];
+static __thread int valid_;
+static __thread struct glstate_stats stats_;
+
+static void ensure_valid()
+{
+    if (valid_)
+        return;
+    program_ = UNKNOWN;
+    active_texture_ = UNKNOWN;
+    vao_ = UNKNOWN;
+    memset(textures_, 0xff, sizeof(textures_));
+    memset(buffers_, 0xff, sizeof(buffers_));
+    valid_ = 1;
+}
+
+static int texture_target_index(GLenum target)
+{
+    switch (target)
+    {
+    case GL_TEXTURE_2D: return TARGET_2D;
+    case GL_TEXTURE_2D_ARRAY: return TARGET_2D_ARRAY;
+    default: return -1;
+    }
+}
+
+static int buffer_target_index(GLenum target)
+{
+    switch (target)
+    {
+    case GL_ARRAY_BUFFER: return BUFFER_ARRAY;
+    case GL_ELEMENT_ARRAY_BUFFER: return BUFFER_ELEMENT_ARRAY;
+    case GL_PIXEL_PACK_BUFFER: return BUFFER_PIXEL_PACK;
+    case GL_PIXEL_UNPACK_BUFFER: return BUFFER_PIXEL_UNPACK;
+    case GL_UNIFORM_BUFFER: return BUFFER_UNIFORM;
+    default: return -1;
+    }
+}
+
+void glstate_use_program(GLuint program)
+{
+    ensure_valid();
+    if (program_ == program)
+    {
+        ++stats_.elided;
+        return;
+    }
+    glUseProgram(program);
+    program_ = program;
+    ++stats_.issued;
+}
+
+void glstate_active_texture(GLenum texture_id)
+{
+    ensure_valid();
+    if (active_texture_ == texture_id)
+    {
+        ++stats_.elided;
+        return;
+    }
+    glActiveTexture(texture_id);
+    active_texture_ = texture_id;
+    ++stats_.issued;
+}
+
+void glstate_bind_texture(GLenum target, GLuint texture)
+{
+    ensure_valid();
+    int unit = active_texture_ - GL_TEXTURE0;
+    int index = texture_target_index(target);
+    if (active_texture_ == UNKNOWN || unit < 0 || unit >= GLSTATE_MAX_UNITS || index < 0)
+    {
+        // untracked, pass through
+        glBindTexture(target, texture);
+        ++stats_.issued;
+        return;
+    }
+    if (textures_[unit][index] == texture)
+    {
+        ++stats_.elided;
+        return;
+    }
+    glBindTexture(target, texture);
+    textures_[unit][index] = texture;
+    ++stats_.issued;
+}
+
+void glstate_bind_vertex_array(GLuint vao)
+{
+    ensure_valid();
+    if (vao_ == vao)
+    {
+        ++stats_.elided;
+        return;
+    }
+    glBindVertexArray(vao);
+    vao_ = vao;
+    buffers_[BUFFER_ELEMENT_ARRAY] = UNKNOWN;
+    ++stats_.issued;
+}
+
+void glstate_bind_buffer(GLenum target, GLuint buffer)
+{
+    ensure_valid();
+    int index = buffer_target_index(target);
+    if (index < 0)
+    {
+        glBindBuffer(target, buffer);
+        ++stats_.issued;
+        return;
+    }
+    if (buffers_[index] == buffer)
+    {
+        ++stats_.elided;
+        return;
+    }
+    glBindBuffer(target, buffer);
+    buffers_[index] = buffer;
+    ++stats_.issued;
+}
+
+void glstate_invalidate()
+{
+    valid_ = 0;
+}
+
+void glstate_get_stats(struct glstate_stats *stats)
+{
+    *stats = stats_;
+}
+
+void glstate_reset_stats()
+{
+    memset(&stats_, 0, sizeof(stats_));
+}
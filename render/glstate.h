@@ -0,0 +1,40 @@
+#ifndef GLSTATE_H__
+#define GLSTATE_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#include <stddef.h>
+#include <GLES3/gl3.h>
+
+#define GLSTATE_MAX_UNITS 16
+
+    // calls that reached GL vs calls dropped because the state already matched
+    struct glstate_stats
+    {
+        size_t issued;
+        size_t elided;
+    };
+
+    // shadowed wrappers, skip the GL call when nothing would change;
+    // everything in the per-frame path binds through these so the shadow stays exact;
+    // shadow and stats are per thread, i.e. per current context
+    void glstate_use_program(GLuint program);
+    void glstate_active_texture(GLenum texture_id);
+    // binds on the current active unit, GL_TEXTURE_2D and GL_TEXTURE_2D_ARRAY are tracked
+    void glstate_bind_texture(GLenum target, GLuint texture);
+    void glstate_bind_vertex_array(GLuint vao);
+    void glstate_bind_buffer(GLenum target, GLuint buffer);
+
+    // forget the shadow, needed after raw GL binds or deleting bound objects
+    void glstate_invalidate();
+
+    void glstate_get_stats(struct glstate_stats *stats);
+    void glstate_reset_stats();
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // GLSTATE_H__
@@ -0,0 +1,212 @@
+#include <string.h>
+#include <GLES3/gl3.h>
+#include <GLES2/gl2ext.h>
+#include <EGL/egl.h>
+#include "gpu_timer.h"
+#include "frame_timing.h"
+#include "log.h"
+
+// in-flight measurements per stage; a slot still pending when its turn
+// comes again is skipped for that frame instead of waited on
+#define GPU_TIMER_RING 8
+
+struct gpu_timer_slot
+{
+    GLuint query;
+    GLsync fence;
+    uint64_t begin_ns; // CPU submit time, fence fallback only
+    size_t frame;
+    int pending;
+};
+
+static struct
+{
+    enum gpu_timer_mode mode; // OFF, AUTO (queries) or FENCE after init
+    struct gpu_timer_slot slots[GPU_TIMER_STAGE_COUNT][GPU_TIMER_RING];
+    size_t next[GPU_TIMER_STAGE_COUNT];
+    struct gpu_timer_slot *active;
+    size_t skipped;
+    size_t disjoint;
+
+    PFNGLGENQUERIESEXTPROC gen_queries;
+    PFNGLDELETEQUERIESEXTPROC delete_queries;
+    PFNGLBEGINQUERYEXTPROC begin_query;
+    PFNGLENDQUERYEXTPROC end_query;
+    PFNGLGETQUERYOBJECTUIVEXTPROC get_query_uiv;
+    PFNGLGETQUERYOBJECTUI64VEXTPROC get_query_ui64v;
+} timer_;
+
+static int has_extension(const char *name)
+{
+    const char *extensions = (const char *)glGetString(GL_EXTENSIONS);
+    size_t len = strlen(name);
+    for (const char *p = extensions; p && (p = strstr(p, name)); p += len)
+        if ((p == extensions || p[-1] == ' ') && (p[len] == ' ' || p[len] == '\0'))
+            return 1;
+    return 0;
+}
+
+static int load_query_functions()
+{
+    if (!has_extension("GL_EXT_disjoint_timer_query"))
+        return -1;
+
+    timer_.gen_queries = (PFNGLGENQUERIESEXTPROC)eglGetProcAddress("glGenQueriesEXT");
+    timer_.delete_queries = (PFNGLDELETEQUERIESEXTPROC)eglGetProcAddress("glDeleteQueriesEXT");
+    timer_.begin_query = (PFNGLBEGINQUERYEXTPROC)eglGetProcAddress("glBeginQueryEXT");
+    timer_.end_query = (PFNGLENDQUERYEXTPROC)eglGetProcAddress("glEndQueryEXT");
+    timer_.get_query_uiv = (PFNGLGETQUERYOBJECTUIVEXTPROC)eglGetProcAddress("glGetQueryObjectuivEXT");
+    timer_.get_query_ui64v = (PFNGLGETQUERYOBJECTUI64VEXTPROC)eglGetProcAddress("glGetQueryObjectui64vEXT");
+    if (!timer_.gen_queries || !timer_.delete_queries || !timer_.begin_query || !timer_.end_query ||
+        !timer_.get_query_uiv || !timer_.get_query_ui64v)
+        return -1;
+
+    return 0;
+}
+
+int gpu_timer_init(enum gpu_timer_mode mode)
+{
+    memset(&timer_, 0, sizeof(timer_));
+    if (mode == GPU_TIMER_OFF)
+        return 0;
+
+    if (mode == GPU_TIMER_AUTO && load_query_functions() == 0)
+    {
+        for (int s = 0; s < GPU_TIMER_STAGE_COUNT; s++)
+            for (int i = 0; i < GPU_TIMER_RING; i++)
+                timer_.gen_queries(1, &timer_.slots[s][i].query);
+        timer_.mode = GPU_TIMER_AUTO;
+        loginfo("gpu timer: GL_EXT_disjoint_timer_query");
+    }
+    else
+    {
+        timer_.mode = GPU_TIMER_FENCE;
+        loginfo("gpu timer: fences (submit to completion latency, polled once per frame)");
+    }
+
+    return 0;
+}
+
+// 1 if the slot's result was consumed (or discarded), 0 if the GPU is not done yet
+static int collect_slot(enum gpu_timer_stage stage, struct gpu_timer_slot *slot)
+{
+    if (timer_.mode == GPU_TIMER_AUTO)
+    {
+        GLuint available = 0;
+        timer_.get_query_uiv(slot->query, GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+        if (!available)
+            return 0;
+        GLuint64 ns = 0;
+        timer_.get_query_ui64v(slot->query, GL_QUERY_RESULT_EXT, &ns);
+        // the first queries of a fresh context can come back as raw
+        // timestamps (seen on llvmpipe), frame 0 is warm-up anyway
+        if (slot->frame > 0)
+            timing_record(slot->frame, TIMING_GPU_UPLOAD + stage, ns);
+    }
+    else
+    {
+        GLenum ret = glClientWaitSync(slot->fence, 0, 0);
+        if (ret == GL_TIMEOUT_EXPIRED)
+            return 0;
+        if (ret != GL_WAIT_FAILED)
+            timing_record(slot->frame, TIMING_GPU_UPLOAD + stage, timing_now_ns() - slot->begin_ns);
+        glDeleteSync(slot->fence);
+        slot->fence = 0;
+    }
+
+    slot->pending = 0;
+    return 1;
+}
+
+void gpu_timer_begin(enum gpu_timer_stage stage)
+{
+    if (timer_.mode == GPU_TIMER_OFF)
+        return;
+
+    struct gpu_timer_slot *slot = &timer_.slots[stage][timer_.next[stage] % GPU_TIMER_RING];
+    if (slot->pending && !collect_slot(stage, slot))
+    {
+        // the GPU is GPU_TIMER_RING frames behind, do not block on it
+        timer_.skipped++;
+        timer_.active = NULL;
+        return;
+    }
+
+    slot->frame = timing_frame_index();
+    if (timer_.mode == GPU_TIMER_AUTO)
+        timer_.begin_query(GL_TIME_ELAPSED_EXT, slot->query);
+    else
+        slot->begin_ns = timing_now_ns();
+    timer_.active = slot;
+}
+
+void gpu_timer_end(enum gpu_timer_stage stage)
+{
+    struct gpu_timer_slot *slot = timer_.active;
+    if (timer_.mode == GPU_TIMER_OFF || !slot)
+        return;
+
+    if (timer_.mode == GPU_TIMER_AUTO)
+        timer_.end_query(GL_TIME_ELAPSED_EXT);
+    else
+        slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot->pending = 1;
+    timer_.next[stage]++;
+    timer_.active = NULL;
+}
+
+void gpu_timer_collect()
+{
+    if (timer_.mode == GPU_TIMER_OFF)
+        return;
+
+    // a disjoint event (power state change, ...) makes every pending result meaningless
+    if (timer_.mode == GPU_TIMER_AUTO)
+    {
+        GLint disjoint = 0;
+        glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+        if (disjoint)
+        {
+            for (int s = 0; s < GPU_TIMER_STAGE_COUNT; s++)
+                for (int i = 0; i < GPU_TIMER_RING; i++)
+                    timer_.slots[s][i].pending = 0;
+            timer_.disjoint++;
+            return;
+        }
+    }
+
+    // oldest first, stop at the first one still in flight
+    for (int s = 0; s < GPU_TIMER_STAGE_COUNT; s++)
+    {
+        size_t first = timer_.next[s] > GPU_TIMER_RING ? timer_.next[s] - GPU_TIMER_RING : 0;
+        for (size_t i = first; i < timer_.next[s]; i++)
+        {
+            struct gpu_timer_slot *slot = &timer_.slots[s][i % GPU_TIMER_RING];
+            if (slot->pending && !collect_slot(s, slot))
+                break;
+        }
+    }
+}
+
+void gpu_timer_destroy()
+{
+    if (timer_.mode == GPU_TIMER_OFF)
+        return;
+
+    if (timer_.skipped > 0 || timer_.disjoint > 0)
+        loginfo("gpu timer: %zu measurements skipped (GPU too far behind), %zu disjoint resets",
+            timer_.skipped, timer_.disjoint);
+
+    for (int s = 0; s < GPU_TIMER_STAGE_COUNT; s++)
+    {
+        for (int i = 0; i < GPU_TIMER_RING; i++)
+        {
+            struct gpu_timer_slot *slot = &timer_.slots[s][i];
+            if (slot->query)
+                timer_.delete_queries(1, &slot->query);
+            if (slot->fence)
+                glDeleteSync(slot->fence);
+        }
+    }
+    memset(&timer_, 0, sizeof(timer_));
+}
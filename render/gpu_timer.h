@@ -0,0 +1,39 @@
+#ifndef GPU_TIMER_H__
+#define GPU_TIMER_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+    enum gpu_timer_mode
+    {
+        GPU_TIMER_OFF,
+        GPU_TIMER_AUTO,  // GL_EXT_disjoint_timer_query if present, else fences
+        GPU_TIMER_FENCE, // force the fence fallback
+    };
+
+    enum gpu_timer_stage
+    {
+        GPU_TIMER_UPLOAD,
+        GPU_TIMER_DRAW,
+        GPU_TIMER_STAGE_COUNT,
+    };
+
+    // needs the GL context current; results go to frame_timing as
+    // TIMING_GPU_UPLOAD / TIMING_GPU_DRAW of the frame they were issued in
+    int gpu_timer_init(enum gpu_timer_mode mode);
+
+    // bracket the GL commands of <stage>, stages must not nest
+    void gpu_timer_begin(enum gpu_timer_stage stage);
+    void gpu_timer_end(enum gpu_timer_stage stage);
+
+    // hand every finished measurement to frame_timing, never waits on the GPU
+    void gpu_timer_collect();
+
+    void gpu_timer_destroy();
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // GPU_TIMER_H__
@@ -0,0 +1,84 @@
+#ifndef HDR_H__
+#define HDR_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+    // transfer function of high bit depth content, mirrored by the `transfer` uniform of HDR_GLSL
+    enum hdr_transfer
+    {
+        HDR_TRANSFER_SDR, // BT.2020 gamma, gamut mapped only
+        HDR_TRANSFER_PQ,  // SMPTE ST 2084
+        HDR_TRANSFER_HLG, // ARIB STD-B67
+    };
+
+// GLSL helpers shared by the high bit depth fragment shaders, pasted after the precision line:
+//   texture_bilinear(): filtering for integer textures, which the sampler cannot do
+//   yuv2020_to_rgb():   limited range BT.2020 non-constant luminance YCbCr to R'G'B'
+//   hdr_to_sdr():       R'G'B' BT.2020 to display referred BT.709 with gamma 2.2
+#define HDR_GLSL                                                                        \
+    "uniform int transfer;                                                          \n" \
+    "vec4 texture_bilinear(highp usampler2D tex, vec2 uv)                           \n" \
+    "{                                                                              \n" \
+    "    ivec2 size = textureSize(tex, 0);                                          \n" \
+    "    vec2 p = uv * vec2(size) - 0.5;                                            \n" \
+    "    ivec2 i = ivec2(floor(p));                                                 \n" \
+    "    vec2 f = fract(p);                                                         \n" \
+    "    ivec2 m = size - 1;                                                        \n" \
+    "    vec4 a = vec4(texelFetch(tex, clamp(i, ivec2(0), m), 0));                  \n" \
+    "    vec4 b = vec4(texelFetch(tex, clamp(i + ivec2(1, 0), ivec2(0), m), 0));    \n" \
+    "    vec4 c = vec4(texelFetch(tex, clamp(i + ivec2(0, 1), ivec2(0), m), 0));    \n" \
+    "    vec4 d = vec4(texelFetch(tex, clamp(i + ivec2(1, 1), ivec2(0), m), 0));    \n" \
+    "    return mix(mix(a, b, f.x), mix(c, d, f.x), f.y);                           \n" \
+    "}                                                                              \n" \
+    "vec3 yuv2020_to_rgb(vec3 yuv)                                                  \n" \
+    "{                                                                              \n" \
+    "    yuv.x = (yuv.x - 64.0 / 1023.0) * (1023.0 / 876.0);                        \n" \
+    "    yuv.yz = (yuv.yz - 512.0 / 1023.0) * (1023.0 / 896.0);                     \n" \
+    "    return mat3(1,       1,        1,                                          \n" \
+    "                0,       -0.16455, 1.8814,                                     \n" \
+    "                1.4746,  -0.57135, 0.0   ) * yuv;                              \n" \
+    "}                                                                              \n" \
+    "vec3 pq_eotf(vec3 e)                                                           \n" \
+    "{                                                                              \n" \
+    "    vec3 p = pow(clamp(e, 0.0, 1.0), vec3(1.0 / 78.84375));                    \n" \
+    "    vec3 l = max(p - 0.8359375, 0.0) / (18.8515625 - 18.6875 * p);             \n" \
+    "    return pow(l, vec3(1.0 / 0.1593017578125)) * 10000.0;                      \n" \
+    "}                                                                              \n" \
+    "vec3 hlg_eotf(vec3 e)                                                          \n" \
+    "{                                                                              \n" \
+    "    e = clamp(e, 0.0, 1.0);                                                    \n" \
+    "    vec3 lo = e * e / 3.0;                                                     \n" \
+    "    vec3 hi = (exp((e - 0.55991073) / 0.17883277) + 0.28466892) / 12.0;        \n" \
+    "    vec3 s = mix(lo, hi, step(0.5, e));                                        \n" \
+    "    float ys = dot(s, vec3(0.2627, 0.6780, 0.0593));                           \n" \
+    "    return 1000.0 * pow(max(ys, 1e-6), 0.2) * s;                               \n" \
+    "}                                                                              \n" \
+    "vec3 hdr_to_sdr(vec3 rgb)                                                      \n" \
+    "{                                                                              \n" \
+    "    vec3 lin;                                                                  \n" \
+    "    if (transfer == 1)                                                         \n" \
+    "        lin = pq_eotf(rgb) / 203.0;                                            \n" \
+    "    else if (transfer == 2)                                                    \n" \
+    "        lin = hlg_eotf(rgb) / 203.0;                                           \n" \
+    "    else                                                                       \n" \
+    "        lin = pow(clamp(rgb, 0.0, 1.0), vec3(2.4));                            \n" \
+    "    lin = mat3(1.6605, -0.1246, -0.0182,                                       \n" \
+    "               -0.5876, 1.1329, -0.1006,                                       \n" \
+    "               -0.0728, -0.0083, 1.1187) * lin;                                \n" \
+    "    if (transfer != 0)                                                         \n" \
+    "    {                                                                          \n" \
+    "        float peak = 1000.0 / 203.0;                                           \n" \
+    "        float l = dot(lin, vec3(0.2126, 0.7152, 0.0722));                      \n" \
+    "        float lm = l * (1.0 + l / (peak * peak)) / (1.0 + l);                  \n" \
+    "        lin *= l > 0.0 ? lm / l : 0.0;                                         \n" \
+    "    }                                                                          \n" \
+    "    return pow(clamp(lin, 0.0, 1.0), vec3(1.0 / 2.2));                         \n" \
+    "}                                                                              \n"
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // HDR_H__
@@ -0,0 +1,22 @@
+#ifndef I420_H__
+#define I420_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#include "format.h"
+
+    // I420: Y plane, then U and V planes at half width and height
+    void i420_init(struct format_state *st, int width, int height);
+    // YV12: same layout as I420 with the V plane first, shares the other entry points
+    void yv12_init(struct format_state *st, int width, int height);
+    int i420_init_shader(struct format_state *st);
+    void i420_init_texture(struct format_state *st, void *buffer);
+    void i420_update_texture(struct format_state *st, void *buffer);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // I420_H__
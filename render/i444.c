@@ -0,0 +1,75 @@
+#include "i444.h"
+#include "log.h"
+
+static char vertex_shader_src[] =
+    "#version 320 es                          \n"
+    "layout (location = 0) in vec3 aPos;      \n"
+    "layout (location = 1) in vec2 aTexCoord; \n"
+    "out vec2 TexCoord;                       \n"
+    "void main()                              \n"
+    "{                                        \n"
+    "    gl_Position = vec4(aPos, 1.0);       \n"
+    "    TexCoord = aTexCoord;                \n"
+    "}                                        \n";
+static char fragment_shader_src[] =
+    "#version 320 es                                                    \n"
+    "precision mediump float;                                           \n" // OpenGL ES need explicit precision
+    "out vec4 FragColor;                                                \n"
+    "in vec2 TexCoord;                                                  \n"
+    "uniform sampler2D y_texture;                                       \n"
+    "uniform sampler2D u_texture;                                       \n"
+    "uniform sampler2D v_texture;                                       \n"
+    "void main()                                                        \n"
+    "{                                                                  \n"
+    "    vec3 yuv;                                                      \n"
+    "    yuv.x = texture(y_texture, TexCoord).r;                        \n"
+    "    yuv.y = texture(u_texture, TexCoord).r - 0.5;                  \n"
+    "    yuv.z = texture(v_texture, TexCoord).r - 0.5;                  \n"
+    "    vec3 rgb = mat3(1,       1,        1,                          \n"
+    "                    0,       -0.39465, 2.03211,                    \n"
+    "                    1.13983, -0.58060, 0.0     ) * yuv;            \n"
+    "    FragColor = vec4(rgb, 1.0);                                    \n"
+    "}                                                                  \n";
+
+void i444_init(struct format_state *st, int width, int height)
+{
+    st->width = width;
+    st->height = height;
+}
+
+int i444_init_shader(struct format_state *st)
+{
+    st->program = create_program(vertex_shader_src, fragment_shader_src);
+    if (st->program == 0)
+    {
+        logerror("create_program failed");
+        return -1;
+    }
+
+    glstate_use_program(st->program);
+
+    glUniform1i(glGetUniformLocation(st->program, "y_texture"), 0); // 0 for GL_TEXTURE0
+    glUniform1i(glGetUniformLocation(st->program, "u_texture"), 1);
+    glUniform1i(glGetUniformLocation(st->program, "v_texture"), 2);
+
+    glClearColor(1.0f, 1.0f, 1.0f, 0.0f);
+
+    return 0;
+}
+
+void i444_init_texture(struct format_state *st, void *buffer)
+{
+    st->texture_count = 3;
+    glGenTextures(st->texture_count, st->textures);
+
+    load_texture(st->upload, GL_TEXTURE0, st->textures[0], GL_RED, st->width, st->height, buffer);
+    load_texture(st->upload, GL_TEXTURE1, st->textures[1], GL_RED, st->width, st->height, buffer + st->width * st->height);
+    load_texture(st->upload, GL_TEXTURE2, st->textures[2], GL_RED, st->width, st->height, buffer + st->width * st->height * 2);
+}
+
+void i444_update_texture(struct format_state *st, void *buffer)
+{
+    update_texture(st->upload, GL_TEXTURE0, st->textures[0], GL_RED, st->width, st->height, buffer);
+    update_texture(st->upload, GL_TEXTURE1, st->textures[1], GL_RED, st->width, st->height, buffer + st->width * st->height);
+    update_texture(st->upload, GL_TEXTURE2, st->textures[2], GL_RED, st->width, st->height, buffer + st->width * st->height * 2);
+}
@@ -0,0 +1,19 @@
+#ifndef I444_H__
+#define I444_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#include "format.h"
+
+    void i444_init(struct format_state *st, int width, int height);
+    int i444_init_shader(struct format_state *st);
+    void i444_init_texture(struct format_state *st, void *buffer);
+    void i444_update_texture(struct format_state *st, void *buffer);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // I444_H__
\ No newline at end of file
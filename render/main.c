@@ -2,327 +2,839 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
-#include <X11/Xlib.h>
-#include <X11/Xutil.h>
+#include <unistd.h>
 #include <GLES3/gl3.h>
-#include <EGL/egl.h>
-#include <EGL/eglext.h>
 #include "log.h"
-#include "nv24.h"
-#include "rgb24.h"
+#include "x11.h"
+#include "egl.h"
+#include "util.h"
+#include "source.h"
+#include "format.h"
+#include "y4m.h"
+#include "shm_ring.h"
+#include "hdr.h"
+#include "program_cache.h"
+#include "frame_timing.h"
+#include "gpu_timer.h"
+#include "trace.h"
+#include "recorder.h"
+#include "cpu_convert.h"
+#include "wall.h"
+#include "upload_thread.h"
+#include "renderer.h"
+#include "event_loop.h"
+#include "present.h"
 
 #define WINDOW_WIDTH 960
 #define WINDOW_HEIGHT 540
 #define WINDOW_TITLE "Render"
-#define NV24_FILENAME "../assets/Kimono_1920x1080_30_1_NV24.yuv"
-#define NV24_WIDTH 1920
-#define NV24_HEIGHT 1080
-#define RGB24_FILENAME "../assets/Kimono_1920x1080_30_1_RGB24.yuv"
-#define RGB24_WIDTH 1920
-#define RGB24_HEIGHT 1080
-
-enum pixel_format
+// clip played when no file is given
+#define DEFAULT_FILENAME "../assets/Kimono_1920x1080_30_1_RGB24.yuv"
+#define DEFAULT_FORMAT "rgb24"
+#define DEFAULT_WIDTH 1920
+#define DEFAULT_HEIGHT 1080
+
+enum source_kind
 {
-    NV24,
-    RGB24,
+    SOURCE_STILL,
+    SOURCE_STREAM,
+    SOURCE_MMAP,
+    SOURCE_SHM,
 };
 
-static enum pixel_format fmt = RGB24;
-
-static EGLint get_context_render_type(EGLDisplay egl_display)
+static void usage(const char *prog)
 {
-    const char *extensions = eglQueryString(egl_display, EGL_EXTENSIONS);
-    if (extensions != NULL && strstr(extensions, "EGL_KHR_create_context"))
-        return EGL_OPENGL_ES3_BIT_KHR;
-    return EGL_OPENGL_ES2_BIT;
+    // queued log records first, so errors print above the usage text
+    log_flush();
+    fprintf(stderr,
+        "usage: %s [options] [file...]\n"
+        "  file        raw frames, or a .y4m stream whose header sets format and geometry\n"
+        "              (default: " DEFAULT_FILENAME ")\n"
+        "  -f <format> raw file pixel format: %s (default: " DEFAULT_FORMAT ")\n"
+        "  -g <WxH>    raw file geometry (default: 1920x1080)\n"
+        "  -t <tf>     transfer of 10/16-bit formats: pq (default), hlg or sdr\n"
+        "  -H          headless: render offscreen without a window or vsync\n"
+        "  -n <count>  stop after <count> frames (default: run until closed)\n"
+        "  -u <mode>   texture upload: direct (default) or pbo\n"
+        "  -b <count>  PBO ring depth per plane for -u pbo (default: 3)\n"
+        "  -d <tile>   upload only changed <tile>x<tile> tiles, skip duplicate frames (default: off)\n"
+        "  -s <source> frame source: still (first frame, default), stream, mmap, or shm: file is the\n"
+        "              shared memory ring of a producer process, e.g. shm_producer, giving format and size\n"
+        "  -q <depth>  stream queue depth (default: 4)\n"
+        "  -p <policy> stream policy when the queue is full: block (default), drop or latest\n"
+        "  -l          stream/mmap: loop at end of file\n"
+        "  -r <fps>    frame clock: take a new frame every 1/<fps> s and sleep in poll in between,\n"
+        "              0 to take frames as the source signals them; default the source's rate in a\n"
+        "              window, headless runs flat out unless given\n"
+        "  -R <hz>     present on a <hz> display: each refresh shows the frame due by the source\n"
+        "              timestamps, repeating or dropping frames (3:2 for 24 fps on 60 Hz); default 60 in\n"
+        "              a window when frames have timestamps, 0 to turn off; not with -r, -U or -c\n"
+        "  -F <fps>    source frame rate for timestamps, overrides the Y4M header; raw files have none\n"
+        "  -j <frame>  mmap: start at frame index <frame>\n"
+        "  -T <file>   write per-frame stage timings to CSV at exit (default: $FRAME_TIMING_CSV)\n"
+        "  -G <mode>   GPU time of upload and draw: auto (timer queries, else fences) or fence\n"
+        "  -e <file>   record a Chrome trace-event JSON, written at exit or on key 't' (default: $TRACE_FILE)\n"
+        "  -o <file>   record the rendered output: *.y4m as 4:4:4 Y4M, otherwise raw rgb24\n"
+        "  -c <file>   batch convert: every frame of the input to <file> (as -o) at source resolution,\n"
+        "              headless and as fast as possible; implies -H -s stream -p block\n"
+        "  -W <count>  video wall of <count> streams of nv24, i444 or rgb24, cycling through the files\n"
+        "              given, which must share format and size; one instanced draw for all tiles\n"
+        "  -U <sets>   upload (and -C convert) on a worker thread with a shared context, rotating\n"
+        "              through <sets> texture sets, 3 or more; not with -W, -d or -c\n"
+        "  -C          nv24: convert to RGB on the CPU (fastest kernel, all cores) and draw that\n",
+        prog, format_names());
 }
 
-int main()
+// totals over every stream
+static void get_source_stats(struct frame_source **srcs, int count, struct source_stats *total)
 {
-    set_log_level(LOG_LEVEL_DEBUG);
-
-    void (*init_func)(int width, int heith);
-    int (*init_shader_func)();
-    void (*init_texture_func)(void *buffer);
-    void (*update_texture_func)(void *buffer);
-    char *yuv_filename;
-    int yuv_width;
-    int yuv_height;
-    size_t yuv_size;
-
-    switch (fmt)
+    memset(total, 0, sizeof(*total));
+    for (int i = 0; i < count; ++i)
     {
-    case NV24:
-        init_func = nv24_init;
-        init_shader_func = nv24_init_shader;
-        init_texture_func = nv24_init_texture;
-        update_texture_func = nv24_update_texture;
-        yuv_filename = NV24_FILENAME;
-        yuv_width = NV24_WIDTH;
-        yuv_height = NV24_HEIGHT;
-        yuv_size = NV24_WIDTH * NV24_HEIGHT * 3;
-        break;
-    case RGB24:
-        init_func = rgb24_init;
-        init_shader_func = rgb24_init_shader;
-        init_texture_func = rgb24_init_texture;
-        update_texture_func = rgb24_update_texture;
-        yuv_filename = RGB24_FILENAME;
-        yuv_width = RGB24_WIDTH;
-        yuv_height = RGB24_HEIGHT;
-        yuv_size = RGB24_WIDTH * RGB24_HEIGHT * 3;
-        break;
+        struct source_stats stats;
+        srcs[i]->get_stats(srcs[i], &stats);
+        total->frames_read += stats.frames_read;
+        total->frames_acquired += stats.frames_acquired;
+        total->underruns += stats.underruns;
+        total->drops += stats.drops;
     }
+}
 
-    ////////////////////////////////////////////////////////////////////////////
-    //                           X11 initialize                               //
-    ////////////////////////////////////////////////////////////////////////////
-
-    Display *x11_display = XOpenDisplay(NULL);
-    if (!x11_display)
-        logfatal("XOpenDisplay failed");
-
-    Window root = XDefaultRootWindow(x11_display);
-    XSetWindowAttributes swa = {.event_mask = ExposureMask | PointerMotionMask | KeyPressMask};
-    Window x11_window = XCreateWindow(
-        x11_display, root,
-        0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, 0,
-        CopyFromParent, InputOutput,
-        CopyFromParent, CWEventMask,
-        &swa);
-
-    Atom s_wm_delete_message = XInternAtom(x11_display, "WM_DELETE_WINDOW", False);
-    XSetWMProtocols(x11_display, x11_window, &s_wm_delete_message, 1);
-
-    XSetWindowAttributes xattr = {.override_redirect = 0};
-    XChangeWindowAttributes(x11_display, x11_window, CWOverrideRedirect, &xattr);
+// totals over every stream's scheduler
+static void get_present_stats(struct present_scheduler **scheds, int count, struct present_stats *total)
+{
+    memset(total, 0, sizeof(*total));
+    for (int i = 0; i < count; ++i)
+    {
+        struct present_stats stats;
+        present_get_stats(scheds[i], &stats);
+        total->refreshes += stats.refreshes;
+        total->repeats += stats.repeats;
+        total->shown += stats.shown;
+        total->drops += stats.drops;
+        total->underruns += stats.underruns;
+        total->late += stats.late;
+        total->judder_sum_ms += stats.judder_sum_ms;
+        if (stats.judder_max_ms > total->judder_max_ms)
+            total->judder_max_ms = stats.judder_max_ms;
+        for (int c = 0; c <= PRESENT_MAX_CADENCE; ++c)
+            total->cadence[c] += stats.cadence[c];
+    }
+}
 
-    XWMHints hints = {.input = 1, .flags = InputHint};
-    XSetWMHints(x11_display, x11_window, &hints);
+// renderer and -C state for uploads on the upload thread
+struct upload_args
+{
+    struct renderer *renderer;
+    struct cpu_converter *conv;
+    unsigned char *rgb;
+};
 
-    // show window
-    XMapWindow(x11_display, x11_window);
-    XStoreName(x11_display, x11_window, WINDOW_TITLE);
+// the frame to upload: <buffer> itself, or its CPU conversion with -C
+static void *cpu_rgb_frame(struct cpu_converter *conv, void *buffer, unsigned char *rgb)
+{
+    if (!conv)
+        return buffer;
+    cpu_convert_nv24(conv, buffer, rgb);
+    return rgb;
+}
 
-    // get identifiers for the provided atom name strings
-    Atom wm_state = XInternAtom(x11_display, "_NET_WM_STATE", 0);
+static void upload_frame(void *arg, void *frame)
+{
+    struct upload_args *args = arg;
+    renderer_update(args->renderer, cpu_rgb_frame(args->conv, frame, args->rgb));
+}
 
-    XEvent xev = {.type = ClientMessage};
-    xev.xclient.window = x11_window;
-    xev.xclient.message_type = wm_state;
-    xev.xclient.format = 32;
-    xev.xclient.data.l[0] = 1;
-    xev.xclient.data.l[0] = 0;
-    XSendEvent(x11_display, DefaultRootWindow(x11_display), 0, SubstructureNotifyMask, &xev);
+int main(int argc, char *argv[])
+{
+    set_log_level(LOG_LEVEL_DEBUG);
+    // keep stderr writes off the render loop
+    log_async_start();
+
+    int headless = 0;
+    size_t max_frames = 0;
+    enum upload_mode upload = UPLOAD_DIRECT;
+    int pbo_count = 3;
+    int tile_size = 0;
+    enum source_kind source = SOURCE_STILL;
+    int queue_depth = 4;
+    enum source_policy policy = SOURCE_POLICY_BLOCK;
+    int loop = 0;
+    size_t start_frame = 0;
+    const char *timing_csv = NULL;
+    enum gpu_timer_mode gpu_timer = GPU_TIMER_OFF;
+    const char *trace_file = NULL;
+    const char *record_file = NULL;
+    int convert = 0;
+    int cpu = 0;
+    int streams = 1;
+    int wall_mode = 0;
+    int upload_sets = 0;
+    double clock_rate = -1;
+    double refresh_hz = -1;
+    double source_fps = 0;
+    const char *format_name = DEFAULT_FORMAT;
+    int yuv_width = DEFAULT_WIDTH;
+    int yuv_height = DEFAULT_HEIGHT;
+    enum hdr_transfer transfer = HDR_TRANSFER_PQ;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "f:g:t:Hn:u:b:d:s:q:p:lj:r:R:F:T:G:e:o:c:CW:U:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'f': format_name = optarg; break;
+        case 'g':
+            if (sscanf(optarg, "%dx%d", &yuv_width, &yuv_height) != 2 || yuv_width <= 0 || yuv_height <= 0)
+            {
+                usage(argv[0]);
+                return -1;
+            }
+            break;
+        case 't':
+            if (strcmp(optarg, "pq") == 0)
+                transfer = HDR_TRANSFER_PQ;
+            else if (strcmp(optarg, "hlg") == 0)
+                transfer = HDR_TRANSFER_HLG;
+            else if (strcmp(optarg, "sdr") == 0)
+                transfer = HDR_TRANSFER_SDR;
+            else
+            {
+                usage(argv[0]);
+                return -1;
+            }
+            break;
+        case 'H': headless = 1; break;
+        case 'n': max_frames = strtoul(optarg, NULL, 10); break;
+        case 'u':
+            if (strcmp(optarg, "direct") == 0)
+                upload = UPLOAD_DIRECT;
+            else if (strcmp(optarg, "pbo") == 0)
+                upload = UPLOAD_PBO;
+            else
+            {
+                usage(argv[0]);
+                return -1;
+            }
+            break;
+        case 'b': pbo_count = atoi(optarg); break;
+        case 'd': tile_size = atoi(optarg); break;
+        case 's':
+            if (strcmp(optarg, "still") == 0)
+                source = SOURCE_STILL;
+            else if (strcmp(optarg, "stream") == 0)
+                source = SOURCE_STREAM;
+            else if (strcmp(optarg, "mmap") == 0)
+                source = SOURCE_MMAP;
+            else if (strcmp(optarg, "shm") == 0)
+                source = SOURCE_SHM;
+            else
+            {
+                usage(argv[0]);
+                return -1;
+            }
+            break;
+        case 'q': queue_depth = atoi(optarg); break;
+        case 'p':
+            if (strcmp(optarg, "block") == 0)
+                policy = SOURCE_POLICY_BLOCK;
+            else if (strcmp(optarg, "drop") == 0)
+                policy = SOURCE_POLICY_DROP_OLDEST;
+            else if (strcmp(optarg, "latest") == 0)
+                policy = SOURCE_POLICY_LATEST;
+            else
+            {
+                usage(argv[0]);
+                return -1;
+            }
+            break;
+        case 'l': loop = 1; break;
+        case 'r': clock_rate = atof(optarg); break;
+        case 'R': refresh_hz = atof(optarg); break;
+        case 'F': source_fps = atof(optarg); break;
+        case 'j': start_frame = strtoul(optarg, NULL, 10); break;
+        case 'T': timing_csv = optarg; break;
+        case 'e': trace_file = optarg; break;
+        case 'o': record_file = optarg; break;
+        case 'C': cpu = 1; break;
+        case 'U': upload_sets = atoi(optarg); break;
+        case 'W':
+            streams = atoi(optarg);
+            wall_mode = 1;
+            if (streams < 1 || streams > WALL_MAX_STREAMS)
+            {
+                logerror("wall needs 1..%d streams", WALL_MAX_STREAMS);
+                return -1;
+            }
+            break;
+        case 'c':
+            record_file = optarg;
+            convert = 1;
+            break;
+        case 'G':
+            if (strcmp(optarg, "auto") == 0)
+                gpu_timer = GPU_TIMER_AUTO;
+            else if (strcmp(optarg, "fence") == 0)
+                gpu_timer = GPU_TIMER_FENCE;
+            else
+            {
+                logerror("unknown gpu timer mode %s", optarg);
+                usage(argv[0]);
+                return -1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return -1;
+        }
+    }
 
-    ////////////////////////////////////////////////////////////////////////////
-    //                          EGL initialize                                //
-    ////////////////////////////////////////////////////////////////////////////
+    if (convert)
+    {
+        // reader thread, GPU and writer thread overlap; every frame once, nothing dropped
+        headless = 1;
+        if (source != SOURCE_MMAP && source != SOURCE_SHM)
+            source = SOURCE_STREAM;
+        policy = SOURCE_POLICY_BLOCK;
+        loop = 0;
+    }
 
-    EGLNativeDisplayType egl_native_display = x11_display;
-    EGLNativeWindowType egl_native_window = x11_window;
+    // wall streams cycle through every file given, the first one describes them all
+    const char *default_files[] = {DEFAULT_FILENAME};
+    const char **files = optind < argc ? (const char **)argv + optind : default_files;
+    int file_count = optind < argc ? argc - optind : 1;
+    const char *yuv_filename = files[0];
+    struct source_layout layout = {0};
+    double fps = 0;
+    char shm_format[SHM_RING_FORMAT_SIZE];
 
-    EGLDisplay egl_display = eglGetDisplay(egl_native_display);
-    if (egl_display == EGL_NO_DISPLAY)
+    if (source == SOURCE_SHM)
     {
-        logerror("eglGetDisplay failed");
-        return -1;
+        // one consumer per ring, a wall needs a producer per stream
+        if (streams > file_count)
+        {
+            logerror("%d streams need %d shm rings, %d given", streams, streams, file_count);
+            return -1;
+        }
+        if (source_shm_probe(yuv_filename, shm_format, sizeof(shm_format), &yuv_width, &yuv_height, &fps) != 0)
+            return -1;
+        format_name = shm_format;
     }
-
-    // initialize EGL
-    EGLint major_version;
-    EGLint minor_version;
-    if (!eglInitialize(egl_display, &major_version, &minor_version))
+    else if (y4m_probe(yuv_filename))
     {
-        logerror("eglInitialize failed");
-        return -1;
+        FILE *fp = fopen(yuv_filename, "rb");
+        struct y4m_header hdr;
+        int ret = y4m_read_header(fp, &hdr);
+        fclose(fp);
+        if (ret != 0)
+            return -1;
+
+        format_name = y4m_format_name(&hdr);
+        if (!format_name)
+        {
+            logerror("unsupported y4m colorspace C%s", hdr.colorspace);
+            return -1;
+        }
+        yuv_width = hdr.width;
+        yuv_height = hdr.height;
+        if (hdr.fps_den > 0)
+            fps = (double)hdr.fps_num / hdr.fps_den;
+        layout.offset = hdr.header_size;
+        layout.y4m = 1;
     }
 
-    EGLint num_configs = 0;
-    EGLint attrib_list[] = {
-        EGL_RED_SIZE, 5,
-        EGL_GREEN_SIZE, 6,
-        EGL_BLUE_SIZE, 5,
-        EGL_ALPHA_SIZE, EGL_DONT_CARE,
-        EGL_DEPTH_SIZE, EGL_DONT_CARE,
-        EGL_STENCIL_SIZE, EGL_DONT_CARE,
-        EGL_SAMPLE_BUFFERS, 0,
-        EGL_RENDERABLE_TYPE, get_context_render_type(egl_display),
-        EGL_NONE};
-
-    // choose config
-    EGLConfig config;
-    if (!eglChooseConfig(egl_display, attrib_list, &config, 1, &num_configs) || num_configs < 1)
+    if (source_fps > 0)
+        fps = source_fps;
+    layout.fps = fps;
+    if (refresh_hz > 0 && (clock_rate >= 0 || upload_sets || convert))
     {
-        logerror("eglChooseConfig failed");
+        logerror("-R paces frames itself, not with -r, -U or -c");
         return -1;
     }
 
-    // create a surface
-    EGLSurface egl_surface = eglCreateWindowSurface(egl_display, config, egl_native_window, NULL);
-    if (egl_surface == EGL_NO_SURFACE)
+    const struct pixel_format *fmt = format_find(format_name);
+    if (!fmt)
     {
-        logerror("eglCreateWindowSurface failed");
+        logerror("unknown format %s", format_name);
+        usage(argv[0]);
         return -1;
     }
-
-    // create a GL context
-    EGLint context_attribs[] = {EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE};
-    EGLContext egl_context = eglCreateContext(egl_display, config, EGL_NO_CONTEXT, context_attribs);
-    if (egl_context == EGL_NO_CONTEXT)
+    size_t yuv_size = fmt->frame_size(yuv_width, yuv_height);
+    layout.frame_size = yuv_size;
+    loginfo("%s: %s %dx%d, %.3f fps, %zu bytes per frame", yuv_filename, fmt->name, yuv_width, yuv_height, fps, yuv_size);
+
+    // CPU fallback: frames are converted to rgb24 first and drawn by that module
+    struct cpu_converter *cpu_conv = NULL;
+    unsigned char *cpu_rgb = NULL;
+    if (cpu)
+    {
+        if (strcmp(fmt->name, "nv24") != 0)
+        {
+            logerror("-C converts nv24 only, not %s", fmt->name);
+            return -1;
+        }
+        cpu_conv = cpu_converter_create(yuv_width, yuv_height, cpu_isa_best(), 0);
+        cpu_rgb = malloc((size_t)yuv_width * yuv_height * 3);
+        if (!cpu_conv || !cpu_rgb)
+        {
+            logerror("cpu converter setup failed");
+            return -1;
+        }
+        loginfo("cpu conversion: %s kernel", cpu_isa_name(cpu_isa_best()));
+        fmt = format_find("rgb24");
+    }
+    // sets are copies of the format's textures, tiles diff against the previous frame
+    // in the same texture and a conversion must draw its last frame too
+    if (upload_sets && (wall_mode || tile_size || convert))
     {
-        logerror("eglCreateContext failed");
+        logerror("-U does not combine with -W, -d or -c");
         return -1;
     }
-
-    // make context current
-    if (!eglMakeCurrent(egl_display, egl_surface, egl_surface, egl_context))
+    if (wall_mode && (cpu || !wall_supports(fmt->name)))
     {
-        logerror("eglMakeCurrent failed");
+        logerror("a wall shows nv24, i444 or rgb24, not %s%s", fmt->name, cpu ? " with -C" : "");
         return -1;
     }
 
     ////////////////////////////////////////////////////////////////////////////
-    //                       VBO/VAO/EBO                                      //
+    //                        X11/EGL initialize                              //
     ////////////////////////////////////////////////////////////////////////////
 
-    GLuint VBO, VAO, EBO;
-    glGenVertexArrays(1, &VAO); // create VAO(vertex Array object)
-    glGenBuffers(1, &VBO);      // create VBO(vertex buffer object)
-    glGenBuffers(1, &EBO);      // create EBO(element buffer object)
-
-    glBindVertexArray(VAO); // bind VAO, for buffer config & vertex config
-
-    // vertex:                                   texture:
-    // +------------------------------+
-    // |                              |
-    // |      [2]------------[1]      |         [2]------------[1]
-    // |       |    (0, 0)    |       |          |              |
-    // |      [3]------------[0]      |         [3]------------[0]
-    // |                              |
-    // +------------------------------+
-    // (x, y, z, s, t), (x, y, z) for vertex location, (s, t) for texture
-    float vertices[] = {
-        -1.0f, 1.0f, 0.0f, 0.0f, 0.0f,
-        -1.0f, -1.0f, 0.0f, 0.0f, 1.0f,
-        1.0f, -1.0f, 0.0f, 1.0f, 1.0f,
-        1.0f, 1.0f, 0.0f, 1.0f, 0.0f};
-    glBindBuffer(GL_ARRAY_BUFFER, VBO); // bind VBO, pass vertex data (`vertices`) to GPU
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    // two triagnle -> rectangle
-    unsigned int indices[] = {
-        0, 1, 2,
-        0, 2, 3};
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO); // configure EBO, pass index data (`indices`) to GPU
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-    // config vertex attribute 0 pointer, location
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (const void *)0);
-    glEnableVertexAttribArray(0);
-    // config index attribute 1 pointer, texture location
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (const void *)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    // clear binding for VAO
-    glBindBuffer(GL_ARRAY_BUFFER, GL_NONE);
-    glBindVertexArray(GL_NONE);
+    struct x11_context x11_ctx = {0};
+    struct egl_context egl_ctx = {0};
+
+    if (headless)
+    {
+        // render at source resolution, there is no window to fit
+        if (egl_headless_create(&egl_ctx, yuv_width, yuv_height) != 0)
+        {
+            logerror("egl_headless_create failed");
+            return -1;
+        }
+    }
+    else
+    {
+        if (x11_window_create(&x11_ctx, WINDOW_WIDTH, WINDOW_HEIGHT, WINDOW_TITLE) != 0)
+            logfatal("x11_window_create failed");
+
+        if (egl_window_create(&egl_ctx, x11_ctx.display, x11_ctx.win) != 0)
+        {
+            logerror("egl_window_create failed");
+            return -1;
+        }
+    }
 
     ////////////////////////////////////////////////////////////////////////////
     //                              shader                                    //
     ////////////////////////////////////////////////////////////////////////////
 
-    init_func(yuv_width, yuv_height);
-    if (init_shader_func() != 0)
+    struct wall *wall = NULL;
+    if (wall_mode)
     {
-        logerror("nv24_init_shader failed");
-        return -1;
+        wall = wall_create(fmt->name, yuv_width, yuv_height, streams);
+        if (!wall)
+        {
+            logerror("wall_create failed");
+            return -1;
+        }
     }
 
     ////////////////////////////////////////////////////////////////////////////
     //                             buffer                                     //
     ////////////////////////////////////////////////////////////////////////////
 
-    // read NV24
-    void *buffer = calloc(1, yuv_size);
-    FILE *fp = fopen(yuv_filename, "rb");
-    fread(buffer, 1, yuv_size, fp);
-    fclose(fp);
+    // before the source, so its reader thread gets a track
+    trace_init(trace_file, 0);
+    trace_thread_name("render");
+
+    // one source per stream, a single one unless this is a wall
+    struct frame_source *srcs[WALL_MAX_STREAMS] = {0};
+    void *buffers[WALL_MAX_STREAMS] = {0};
+    for (int i = 0; i < streams; ++i)
+    {
+        const char *filename = files[i % file_count];
+        struct frame_source *src = NULL;
+        switch (source)
+        {
+        case SOURCE_STILL: src = source_still_create(filename, &layout); break;
+        case SOURCE_STREAM: src = source_stream_create(filename, &layout, queue_depth, policy, loop); break;
+        case SOURCE_MMAP: src = source_mmap_create(filename, &layout, loop); break;
+        case SOURCE_SHM: src = source_shm_create(filename, layout.frame_size, policy); break;
+        }
+        if (!src)
+        {
+            logerror("create frame source for %s failed", filename);
+            return -1;
+        }
+
+        if (start_frame > 0)
+        {
+            if (!src->seek)
+            {
+                logerror("frame source cannot seek");
+                return -1;
+            }
+            if (src->seek(src, start_frame) != 0)
+                return -1;
+        }
+
+        if (src->acquire(src, &buffers[i]) != SOURCE_OK)
+        {
+            logerror("no frame in %s", filename);
+            return -1;
+        }
+        srcs[i] = src;
+    }
 
     ////////////////////////////////////////////////////////////////////////////
     //                            texture                                     //
     ////////////////////////////////////////////////////////////////////////////
 
-    init_texture_func(buffer);
+    // rows of odd widths are not 4 byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    // the wall's layers are filled by the first loop iteration
+    struct renderer *renderer = NULL;
+    if (!wall)
+    {
+        renderer = renderer_create(fmt, yuv_width, yuv_height, transfer, cpu_rgb_frame(cpu_conv, buffers[0], cpu_rgb));
+        if (!renderer)
+        {
+            logerror("renderer_create failed");
+            return -1;
+        }
+        set_upload_mode(renderer_upload_state(renderer), upload, pbo_count);
+        set_dirty_tiles(renderer_upload_state(renderer), tile_size);
+    }
+    program_cache_report();
+
+    struct upload_args upload_args = {renderer, cpu_conv, cpu_rgb};
+    struct upload_thread *uploader = NULL;
+    if (upload_sets)
+    {
+        uploader = upload_thread_create(&egl_ctx, renderer_upload_state(renderer), upload_sets, upload_frame, &upload_args);
+        if (!uploader)
+        {
+            logerror("upload_thread_create failed");
+            return -1;
+        }
+    }
+
+    struct recorder *recorder = NULL;
+    if (record_file)
+    {
+        EGLint out_width = egl_ctx.width, out_height = egl_ctx.height;
+        if (!headless)
+        {
+            eglQuerySurface(egl_ctx.display, egl_ctx.surface, EGL_WIDTH, &out_width);
+            eglQuerySurface(egl_ctx.display, egl_ctx.surface, EGL_HEIGHT, &out_height);
+        }
+        recorder = recorder_create(record_file, out_width, out_height, fps, RECORDER_DEFAULT_SLOTS);
+        if (!recorder)
+        {
+            logerror("recorder_create failed");
+            return -1;
+        }
+    }
+    loginfo("upload mode: %s", upload == UPLOAD_PBO ? "pbo" : "direct");
+
+    // presentation scheduler: the clock ticks once per display refresh and each stream
+    // shows the frame its timestamps make due, the upload thread keeps frames it cannot track
+    double refresh = refresh_hz;
+    if (refresh_hz < 0)
+        refresh = !headless && !convert && clock_rate < 0 && !uploader && source != SOURCE_STILL ? PRESENT_DEFAULT_REFRESH : 0;
+    for (int i = 0; refresh > 0 && i < streams; ++i)
+    {
+        if (srcs[i]->pts_ns >= 0)
+            continue;
+        if (refresh_hz > 0)
+        {
+            logerror("-R needs frame timestamps: a Y4M frame rate, -F or a producer setting them");
+            return -1;
+        }
+        refresh = 0;
+    }
+    struct present_scheduler *scheds[WALL_MAX_STREAMS] = {0};
+    for (int i = 0; refresh > 0 && i < streams; ++i)
+    {
+        scheds[i] = present_create(refresh, srcs[i]->pts_ns);
+        if (!scheds[i])
+            return -1;
+    }
+    if (refresh > 0)
+    {
+        // one refresh per swap, so what the scheduler picked lands on the refresh it was picked for
+        egl_set_swap_interval(&egl_ctx, 1);
+        loginfo("present: %.3f fps stream on a %.3f Hz refresh", fps, refresh);
+    }
+
+    // in a window or with -r the loop sleeps in poll while there is nothing new to show,
+    // woken by the X connection and the frame clock, or without a clock by the sources
+    struct event_loop *events = NULL;
+    double clock_fps = 0;
+    int can_sleep = 1; // every source can wake the loop, else it only checks
+    if (!convert && (!headless || clock_rate >= 0 || refresh > 0))
+    {
+        events = event_loop_create();
+        if (!events)
+        {
+            logerror("event_loop_create failed");
+            return -1;
+        }
+        if (!headless)
+            event_loop_add(events, x11_window_fd(&x11_ctx));
+        clock_fps = refresh > 0 ? refresh : clock_rate >= 0 ? clock_rate : fps;
+        if (clock_fps > 0)
+            event_loop_set_clock(events, clock_fps);
+        for (int i = 0; clock_fps <= 0 && i < streams; ++i)
+        {
+            if (srcs[i]->event_fd >= 0)
+                event_loop_add(events, srcs[i]->event_fd);
+            else
+                can_sleep = 0;
+        }
+        if (clock_fps > 0)
+        {
+            loginfo("event loop: %.3f fps frame clock", clock_fps);
+        }
+        else
+        {
+            loginfo("event loop: frames as the source signals them%s", can_sleep ? "" : ", never sleeps without -r");
+        }
+    }
 
     ////////////////////////////////////////////////////////////////////////////
-    //                           X11 loop                                     //
+    //                             loop                                       //
     ////////////////////////////////////////////////////////////////////////////
 
-    XEvent xev2;
     int stop = 0;
+    size_t time_ms_start = 0;
     size_t time_ms_ckpt = 0;
     size_t seq = 0, seq_ckpt = 0;
+    // wall layers replaced, only streams with a new frame are uploaded
+    size_t layer_updates = 0, layer_updates_ckpt = 0;
+    // streams with a new frame this iteration, all of them at the start
+    int fresh[WALL_MAX_STREAMS];
+    for (int i = 0; i < streams; ++i)
+        fresh[i] = 1;
+    struct source_stats stats;
+    struct glstate_stats gl_stats;
+    struct upload_stats up_stats = {0};
+    glstate_reset_stats();
+    if (renderer)
+        take_upload_stats(renderer_upload_state(renderer), &up_stats);
+    timing_init(0, 1000, timing_csv);
+    gpu_timer_init(gpu_timer);
+    int idle = 0; // nothing was drawn last iteration
+    int tick = 0; // the frame clock ticked, time for the next frame
+    uint64_t refreshes = 0; // clock ticks so far, missed ones included
+    size_t sleeps = 0, missed_ticks = 0;
 
     while (!stop)
     {
+        if (idle)
+        {
+            TRACE_BEGIN(idle_begin);
+            int ticks = event_loop_wait(events, can_sleep ? -1 : 0);
+            TRACE_END("idle", idle_begin);
+            tick = ticks > 0;
+            if (ticks > 0)
+                refreshes += ticks;
+            if (ticks > 1)
+                missed_ticks += ticks - 1;
+            ++sleeps;
+            idle = 0;
+        }
+
         // event handle
-        while (XPending(x11_display))
+        int redraw = 0;
+        if (!headless)
         {
-            XNextEvent(x11_display, &xev2);
-            switch (xev2.type)
-            {
-            case KeyPress:
+            int x11_events = x11_window_poll(&x11_ctx);
+            stop = x11_events & X11_EVENT_CLOSE;
+            redraw = x11_events & X11_EVENT_REDRAW;
+        }
+
+        // stats, fps and per-stage latencies come from the timing report
+        struct timespec tp;
+        clock_gettime(CLOCK_MONOTONIC, &tp);
+        size_t time_ms_curr = tp.tv_sec * 1e3 + tp.tv_nsec / 1e6;
+        if (time_ms_start == 0)
+            time_ms_start = time_ms_ckpt = time_ms_curr;
+        if (time_ms_curr - time_ms_ckpt > 1000)
+        {
+            get_source_stats(srcs, streams, &stats);
+            glstate_get_stats(&gl_stats);
+            glstate_reset_stats();
+            if (renderer)
+                take_upload_stats(renderer_upload_state(renderer), &up_stats);
+            double frames = seq > seq_ckpt ? seq - seq_ckpt : 1;
+            loginfo("read: %zu, underruns: %zu, drops: %zu, binds/frame: %.1f issued, %.1f elided, "
+                    "upload/frame: %.1f KB, skipped/frame: %.1f KB",
+                stats.frames_read, stats.underruns, stats.drops,
+                gl_stats.issued / frames, gl_stats.elided / frames,
+                up_stats.uploaded_bytes / frames / 1024, up_stats.skipped_bytes / frames / 1024);
+            if (wall)
+                loginfo("wall: %d streams, %.1f layers updated/frame", streams, (layer_updates - layer_updates_ckpt) / frames);
+            seq_ckpt = seq;
+            layer_updates_ckpt = layer_updates;
+            time_ms_ckpt = time_ms_curr;
+        }
+
+        if (max_frames > 0 && seq >= max_frames)
+            break;
+        timing_mark(TIMING_EVENTS);
+
+        // the first frames are already in the textures
+        int eof = 0;
+        for (int i = 0; seq > 0 && i < streams; ++i)
+        {
+            // with a frame clock the next frame is only taken on a tick
+            if (clock_fps > 0 && !tick)
             {
-                KeySym key;
-                char key_char;
-                if (XLookupString(&xev2.xkey, &key_char, 1, &key, 0))
-                {
-                    loginfo("keypress: %c", key_char);
-                }
+                fresh[i] = 0;
+                continue;
             }
-            break;
-            case ClientMessage:
+            // on underrun keep the current frame and upload it again, a
+            // conversion waits for the reader instead of repeating the frame
+            void *next = buffers[i];
+            enum source_status status = scheds[i] ? present_pick(scheds[i], srcs[i], refreshes, &next) : srcs[i]->acquire(srcs[i], &next);
+            while (convert && status == SOURCE_AGAIN)
             {
-                if (xev2.xclient.data.l[0] == s_wm_delete_message)
-                {
-                    stop = 1;
-                }
+                source_wait(srcs[i], -1);
+                status = srcs[i]->acquire(srcs[i], &next);
             }
-            break;
-            case DestroyNotify:
+            if (status == SOURCE_EOF || status == SOURCE_ERROR)
             {
-                stop = 1;
+                eof = 1;
+                break;
             }
-            break;
+            // a still source hands out the same frame again, nothing new to draw
+            fresh[i] = status == SOURCE_OK && !(events && next == buffers[i]);
+            if (status == SOURCE_OK)
+            {
+                // the upload thread hands frames back itself once it is done with them,
+                // the scheduler has released the frame it replaced
+                if (next != buffers[i] && !uploader && !scheds[i])
+                    srcs[i]->release(srcs[i], buffers[i]);
+                buffers[i] = next;
             }
         }
+        if (eof)
+            break;
+        tick = 0;
+        timing_mark(TIMING_ACQUIRE);
 
-        // fps calc
-        struct timespec tp;
-        clock_gettime(CLOCK_MONOTONIC, &tp);
-        size_t time_ms_curr = tp.tv_sec * 1e3 + tp.tv_nsec / 1e6;
-        if (time_ms_curr - time_ms_ckpt > 1000)
+        // an event loop only draws for a new frame or a window event
+        if (events && seq > 0 && !redraw)
         {
-            loginfo("fps: %d", seq - seq_ckpt);
-            seq_ckpt = seq;
-            time_ms_ckpt = time_ms_curr;
+            int any = 0;
+            for (int i = 0; i < streams; ++i)
+                any |= fresh[i];
+            if (!any)
+            {
+                idle = 1;
+                continue;
+            }
         }
 
         ++seq;
 
-        update_texture_func(buffer);
+        gpu_timer_begin(GPU_TIMER_UPLOAD);
+        if (wall)
+        {
+            void *frames[WALL_MAX_STREAMS];
+            for (int i = 0; i < streams; ++i)
+                frames[i] = fresh[i] ? buffers[i] : NULL;
+            layer_updates += wall_update(wall, frames);
+        }
+        else if (uploader)
+        {
+            // the worker fills the next set while this thread draws the newest finished one
+            if (fresh[0])
+            {
+                void *done = upload_thread_submit(uploader, buffers[0]);
+                if (done && done != buffers[0])
+                    srcs[0]->release(srcs[0], done);
+            }
+            upload_thread_present(uploader);
+        }
+        else if (fresh[0] || !events)
+            renderer_update(renderer, cpu_rgb_frame(cpu_conv, buffers[0], cpu_rgb));
+        gpu_timer_end(GPU_TIMER_UPLOAD);
+        timing_mark(TIMING_UPLOAD);
 
+        gpu_timer_begin(GPU_TIMER_DRAW);
         // clear window
         glClear(GL_COLOR_BUFFER_BIT);
-        // bind VAO
-        glBindVertexArray(VAO);
-        // draw rectangle
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-        // unbind
-        glBindVertexArray(0);
-        glUseProgram(0);
-
-        eglSwapBuffers(egl_display, egl_surface);
+        if (wall)
+            wall_draw(wall);
+        else
+            renderer_draw(renderer);
+        gpu_timer_end(GPU_TIMER_DRAW);
+        timing_mark(TIMING_DRAW);
+
+        // readback of this frame, frames N-2 and older go to the writer thread
+        if (recorder)
+            recorder_capture(recorder);
+
+        egl_swap(&egl_ctx);
+        timing_mark(TIMING_SWAP);
+        gpu_timer_collect();
+        timing_frame_end();
+    }
+
+    glFinish();
+    struct timespec tp;
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    size_t time_ms_total = (size_t)(tp.tv_sec * 1e3 + tp.tv_nsec / 1e6) - time_ms_start;
+    if (time_ms_total > 0)
+        loginfo("frames: %zu, time: %zu ms, average fps: %.2f, upload: %.1f MB/s",
+            seq, time_ms_total, seq * 1e3 / time_ms_total, seq * yuv_size / 1e3 / time_ms_total);
+    get_source_stats(srcs, streams, &stats);
+    loginfo("source read: %zu, acquired: %zu, underruns: %zu, drops: %zu",
+        stats.frames_read, stats.frames_acquired, stats.underruns, stats.drops);
+    if (events)
+        loginfo("event loop: %zu sleeps, %zu clock ticks missed", sleeps, missed_ticks);
+    if (refresh > 0)
+    {
+        struct present_stats present;
+        char cadence[128];
+        get_present_stats(scheds, streams, &present);
+        present_format_cadence(&present, cadence, sizeof(cadence));
+        loginfo("present: %zu refreshes, %zu frames shown, %zu repeats, %zu drops, %zu late, %zu underruns, "
+                "judder mean %.2f max %.2f ms, refreshes per frame: %s",
+            present.refreshes, present.shown, present.repeats, present.drops, present.late, present.underruns,
+            present.shown ? present.judder_sum_ms / present.shown : 0, present.judder_max_ms, cadence);
     }
-}
\ No newline at end of file
+    upload_thread_destroy(uploader);
+    gpu_timer_destroy();
+    timing_destroy();
+    recorder_destroy(recorder);
+    if (convert)
+    {
+        // the writer has drained, so this is the sustained file to file rate
+        clock_gettime(CLOCK_MONOTONIC, &tp);
+        time_ms_total = (size_t)(tp.tv_sec * 1e3 + tp.tv_nsec / 1e6) - time_ms_start;
+        if (time_ms_total > 0)
+            loginfo("converted %zu frames to %s in %zu ms: %.2f fps, %.1f MB/s in",
+                seq, record_file, time_ms_total, seq * 1e3 / time_ms_total, seq * yuv_size / 1e3 / time_ms_total);
+    }
+
+    for (int i = 0; i < streams; ++i)
+    {
+        present_destroy(scheds[i], srcs[i]);
+        srcs[i]->release(srcs[i], buffers[i]);
+        source_destroy(srcs[i]);
+    }
+    event_loop_destroy(events);
+    wall_destroy(wall);
+    cpu_converter_destroy(cpu_conv);
+    free(cpu_rgb);
+    trace_destroy();
+    renderer_destroy(renderer);
+    egl_destroy(&egl_ctx);
+    if (!headless)
+        x11_window_destroy(&x11_ctx);
+
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include "nv12.h"
+#include "log.h"
+
+static char vertex_shader_src[] =
+    "#version 320 es                          \n"
+    "layout (location = 0) in vec3 aPos;      \n"
+    "layout (location = 1) in vec2 aTexCoord; \n"
+    "out vec2 TexCoord;                       \n"
+    "void main()                              \n"
+    "{                                        \n"
+    "    gl_Position = vec4(aPos, 1.0);       \n"
+    "    TexCoord = aTexCoord;                \n"
+    "}                                        \n";
+// the half resolution uv_texture is upsampled by the bilinear sampler
+static char fragment_shader_src[] =
+    "#version 320 es                                                    \n"
+    "precision mediump float;                                           \n" // OpenGL ES need explicit precision
+    "out vec4 FragColor;                                                \n"
+    "in vec2 TexCoord;                                                  \n"
+    "uniform sampler2D y_texture;                                       \n"
+    "uniform sampler2D uv_texture;                                      \n"
+    "void main()                                                        \n"
+    "{                                                                  \n"
+    "    vec3 yuv;                                                      \n"
+    "    yuv.x = texture(y_texture, TexCoord).r;                        \n"
+    "    yuv.yz = texture(uv_texture, TexCoord).rg - vec2(0.5, 0.5);    \n"
+    "    vec3 rgb = mat3(1,       1,        1,                          \n"
+    "                    0,       -0.39465, 2.03211,                    \n"
+    "                    1.13983, -0.58060, 0.0     ) * yuv;            \n"
+    "    FragColor = vec4(rgb, 1.0);                                    \n"
+    "}                                                                  \n";
+
+void nv12_init(struct format_state *st, int width, int height)
+{
+    st->width = width;
+    st->height = height;
+    st->chroma_width = (width + 1) / 2;
+    st->chroma_height = (height + 1) / 2;
+    st->swap = 0;
+}
+
+void nv21_init(struct format_state *st, int width, int height)
+{
+    nv12_init(st, width, height);
+    st->swap = 1;
+}
+
+int nv12_init_shader(struct format_state *st)
+{
+    st->program = create_program(vertex_shader_src, fragment_shader_src);
+    if (st->program == 0)
+    {
+        logerror("create_program failed");
+        return -1;
+    }
+
+    glstate_use_program(st->program);
+
+    glUniform1i(glGetUniformLocation(st->program, "y_texture"), 0); // 0 for GL_TEXTURE0
+    glUniform1i(glGetUniformLocation(st->program, "uv_texture"), 1);
+
+    glClearColor(1.0f, 1.0f, 1.0f, 0.0f);
+
+    return 0;
+}
+
+void nv12_init_texture(struct format_state *st, void *buffer)
+{
+    st->texture_count = 2;
+    glGenTextures(st->texture_count, st->textures);
+
+    load_texture(st->upload, GL_TEXTURE0, st->textures[0], GL_RED, st->width, st->height, buffer);
+    load_texture(st->upload, GL_TEXTURE1, st->textures[1], GL_RG, st->chroma_width, st->chroma_height, buffer + st->width * st->height);
+
+    if (st->swap)
+    {
+        // NV21 stores VU, let the sampler swap it back so the shader is shared
+        glstate_bind_texture(GL_TEXTURE_2D, st->textures[1]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_R, GL_GREEN);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, GL_RED);
+        glstate_bind_texture(GL_TEXTURE_2D, GL_NONE);
+    }
+}
+
+void nv12_update_texture(struct format_state *st, void *buffer)
+{
+    update_texture(st->upload, GL_TEXTURE0, st->textures[0], GL_RED, st->width, st->height, buffer);
+    update_texture(st->upload, GL_TEXTURE1, st->textures[1], GL_RG, st->chroma_width, st->chroma_height, buffer + st->width * st->height);
+}
@@ -0,0 +1,22 @@
+#ifndef NV12_H__
+#define NV12_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#include "format.h"
+
+    // NV12: Y plane + interleaved UV plane at half width and height
+    void nv12_init(struct format_state *st, int width, int height);
+    // NV21: same layout as NV12 with VU order, shares the other entry points
+    void nv21_init(struct format_state *st, int width, int height);
+    int nv12_init_shader(struct format_state *st);
+    void nv12_init_texture(struct format_state *st, void *buffer);
+    void nv12_update_texture(struct format_state *st, void *buffer);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // NV12_H__
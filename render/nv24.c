@@ -29,62 +29,42 @@ static char fragment_shader_src[] =
     "    FragColor = vec4(rgb, 1.0);                                    \n"
     "}                                                                  \n";
 
-static int width_;
-static int height_;
-static GLuint textures_[2];
-GLuint program_;
-
-void nv24_init(int width, int height)
+void nv24_init(struct format_state *st, int width, int height)
 {
-    width_ = width;
-    height_ = height;
+    st->width = width;
+    st->height = height;
 }
 
-int nv24_init_shader()
+int nv24_init_shader(struct format_state *st)
 {
-    GLuint vertex_shader = load_shader(GL_VERTEX_SHADER, vertex_shader_src);
-    if (vertex_shader == 0)
-    {
-        logerror("load_shader VERTEX failed");
-        return -1;
-    }
-
-    GLuint fragment_shader = load_shader(GL_FRAGMENT_SHADER, fragment_shader_src);
-    if (fragment_shader == 0)
-    {
-        logerror("load_shader FRAGMENT failed");
-        return -1;
-    }
-
-    program_ = link_program(vertex_shader, fragment_shader);
-    if (program_ == 0)
+    st->program = create_program(vertex_shader_src, fragment_shader_src);
+    if (st->program == 0)
     {
-        logerror("link_program failed");
+        logerror("create_program failed");
         return -1;
     }
 
-    glUseProgram(program_);
+    glstate_use_program(st->program);
 
-    glUniform1i(glGetUniformLocation(program_, "y_texture"), 0); // 0 for GL_TEXTURE0
-    glUniform1i(glGetUniformLocation(program_, "uv_texture"), 1);
+    glUniform1i(glGetUniformLocation(st->program, "y_texture"), 0); // 0 for GL_TEXTURE0
+    glUniform1i(glGetUniformLocation(st->program, "uv_texture"), 1);
 
     glClearColor(1.0f, 1.0f, 1.0f, 0.0f);
 
     return 0;
 }
 
-void nv24_init_texture(void *buffer)
+void nv24_init_texture(struct format_state *st, void *buffer)
 {
-    glGenTextures(2, textures_);
+    st->texture_count = 2;
+    glGenTextures(st->texture_count, st->textures);
 
-    load_texture(GL_TEXTURE0, textures_[0], GL_RED, width_, height_, buffer);
-    load_texture(GL_TEXTURE1, textures_[1], GL_RG, width_, height_, buffer + width_ * height_);
+    load_texture(st->upload, GL_TEXTURE0, st->textures[0], GL_RED, st->width, st->height, buffer);
+    load_texture(st->upload, GL_TEXTURE1, st->textures[1], GL_RG, st->width, st->height, buffer + st->width * st->height);
 }
 
-void nv24_update_texture(void *buffer)
+void nv24_update_texture(struct format_state *st, void *buffer)
 {
-    update_texture(GL_TEXTURE0, textures_[0], GL_RED, width_, height_, buffer);
-    update_texture(GL_TEXTURE1, textures_[1], GL_RG, width_, height_, buffer + width_ * height_);
-    // use shader program
-    glUseProgram(program_);
+    update_texture(st->upload, GL_TEXTURE0, st->textures[0], GL_RED, st->width, st->height, buffer);
+    update_texture(st->upload, GL_TEXTURE1, st->textures[1], GL_RG, st->width, st->height, buffer + st->width * st->height);
 }
\ No newline at end of file
@@ -6,12 +6,12 @@ extern "C"
 {
 #endif // __cplusplus
 
-#include "util.h"
+#include "format.h"
 
-    void nv24_init(int width, int height);
-    int nv24_init_shader();
-    void nv24_init_texture(void *buffer);
-    void nv24_update_texture(void *buffer);
+    void nv24_init(struct format_state *st, int width, int height);
+    int nv24_init_shader(struct format_state *st);
+    void nv24_init_texture(struct format_state *st, void *buffer);
+    void nv24_update_texture(struct format_state *st, void *buffer);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,22 @@
+#ifndef P010_H__
+#define P010_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#include "format.h"
+
+    // P010: 16-bit little endian Y plane + interleaved UV plane at half size, 10 bits in the high bits
+    void p010_init(struct format_state *st, int width, int height);
+    // P016: same layout with all 16 bits significant, shares the other entry points
+    void p016_init(struct format_state *st, int width, int height);
+    int p010_init_shader(struct format_state *st);
+    void p010_init_texture(struct format_state *st, void *buffer);
+    void p010_update_texture(struct format_state *st, void *buffer);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // P010_H__
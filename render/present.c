@@ -0,0 +1,170 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "present.h"
+#include "log.h"
+
+struct present_scheduler
+{
+    int64_t period_ns;
+
+    // the media clock: base_pts is due at refresh base_tick, one period per refresh after that
+    int64_t base_pts;
+    uint64_t base_tick;
+
+    int64_t cur_pts;   // frame on screen
+    uint64_t cur_tick; // refresh it went on screen
+    int64_t frame_ns;  // last timestamp step, when the next frame is expected
+
+    void *ahead; // acquired, not due yet
+    int64_t ahead_pts;
+
+    uint64_t last_tick;
+    struct present_stats stats;
+};
+
+struct present_scheduler *present_create(double refresh_hz, int64_t first_pts_ns)
+{
+    if (refresh_hz <= 0 || first_pts_ns < 0)
+    {
+        logerror("invalid refresh %.3f Hz or first timestamp %lld", refresh_hz, (long long)first_pts_ns);
+        return NULL;
+    }
+
+    struct present_scheduler *ps = calloc(1, sizeof(*ps));
+    if (!ps)
+    {
+        logerror("calloc failed");
+        return NULL;
+    }
+    ps->period_ns = 1e9 / refresh_hz;
+    ps->base_pts = first_pts_ns;
+    ps->cur_pts = first_pts_ns;
+
+    return ps;
+}
+
+// first refresh at which a frame stamped <pts> is due
+static uint64_t due_tick(struct present_scheduler *ps, int64_t pts)
+{
+    // a quarter period early: frame boundaries of 24, 25, 30 or 50 fps fall on whole or half
+    // 60 Hz periods, so none lands exactly on a refresh and rounding cannot flip the cadence
+    int64_t rel = pts - ps->base_pts - ps->period_ns / 4;
+    if (rel <= 0)
+        return ps->base_tick;
+    return ps->base_tick + (rel + ps->period_ns - 1) / ps->period_ns;
+}
+
+// the frame on screen is replaced at <tick> by one stamped <next_pts>
+static void retire(struct present_scheduler *ps, uint64_t tick, int64_t next_pts)
+{
+    struct present_stats *stats = &ps->stats;
+    uint64_t on_screen = tick - ps->cur_tick;
+    if (on_screen == 0)
+    {
+        // picked for this refresh, then overtaken by a newer due frame
+        ++stats->drops;
+        return;
+    }
+
+    ++stats->shown;
+    ++stats->cadence[on_screen <= PRESENT_MAX_CADENCE ? on_screen : 0];
+    if (ps->cur_tick > due_tick(ps, ps->cur_pts))
+        ++stats->late;
+
+    // how far its time on screen strays from what its timestamps ask for
+    double judder_ms = ((double)on_screen * ps->period_ns - (double)(next_pts - ps->cur_pts)) / 1e6;
+    if (judder_ms < 0)
+        judder_ms = -judder_ms;
+    stats->judder_sum_ms += judder_ms;
+    if (judder_ms > stats->judder_max_ms)
+        stats->judder_max_ms = judder_ms;
+}
+
+enum source_status present_pick(struct present_scheduler *ps, struct frame_source *src, uint64_t tick, void **frame)
+{
+    uint64_t elapsed = tick > ps->last_tick ? tick - ps->last_tick : 0;
+    ps->stats.refreshes += elapsed;
+    ps->last_tick = tick;
+
+    enum source_status status = SOURCE_AGAIN;
+    for (;;)
+    {
+        if (!ps->ahead)
+        {
+            void *next;
+            enum source_status ret = src->acquire(src, &next);
+            if (ret == SOURCE_AGAIN)
+            {
+                // nothing to show although the next frame should be on screen by now
+                if (status == SOURCE_AGAIN && ps->frame_ns > 0 && due_tick(ps, ps->cur_pts + ps->frame_ns) <= tick)
+                    ++ps->stats.underruns;
+                break;
+            }
+            // the end is reported again by the next call
+            if (ret != SOURCE_OK)
+                return status == SOURCE_OK ? SOURCE_OK : ret;
+            // a still source hands out its one frame forever
+            if (next == *frame)
+                break;
+
+            ps->ahead = next;
+            ps->ahead_pts = src->pts_ns;
+            if (ps->ahead_pts <= ps->cur_pts)
+            {
+                // timestamps went back, the source restarted: show it now and follow its clock
+                logwarn("timestamp %lld after %lld, restarting the media clock", (long long)ps->ahead_pts, (long long)ps->cur_pts);
+                ps->base_pts = ps->ahead_pts;
+                ps->base_tick = tick;
+                ps->frame_ns = 0;
+            }
+        }
+        if (due_tick(ps, ps->ahead_pts) > tick)
+            break;
+
+        retire(ps, tick, ps->ahead_pts);
+        if (ps->ahead_pts > ps->cur_pts)
+            ps->frame_ns = ps->ahead_pts - ps->cur_pts;
+        src->release(src, *frame);
+        *frame = ps->ahead;
+        ps->cur_pts = ps->ahead_pts;
+        ps->cur_tick = tick;
+        ps->ahead = NULL;
+        status = SOURCE_OK;
+    }
+
+    // every refresh since the last call kept the old frame, but the one it changed on
+    if (elapsed > 0)
+        ps->stats.repeats += status == SOURCE_OK ? elapsed - 1 : elapsed;
+    return status;
+}
+
+void present_get_stats(struct present_scheduler *ps, struct present_stats *stats)
+{
+    *stats = ps->stats;
+}
+
+void present_format_cadence(const struct present_stats *stats, char *buf, size_t size)
+{
+    size_t len = 0;
+    buf[0] = '\0';
+    for (int i = 1; i <= PRESENT_MAX_CADENCE + 1 && stats->shown > 0; ++i)
+    {
+        int bucket = i <= PRESENT_MAX_CADENCE ? i : 0;
+        if (stats->cadence[bucket] == 0 || len >= size)
+            continue;
+        len += snprintf(buf + len, size - len, "%s%s%d x%.0f%%", len ? " " : "", bucket ? "" : ">",
+            bucket ? bucket : PRESENT_MAX_CADENCE, stats->cadence[bucket] * 100.0 / stats->shown);
+    }
+    if (len == 0)
+        snprintf(buf, size, "-");
+}
+
+void present_destroy(struct present_scheduler *ps, struct frame_source *src)
+{
+    if (!ps)
+        return;
+
+    if (ps->ahead)
+        src->release(src, ps->ahead);
+    free(ps);
+}
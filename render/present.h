@@ -0,0 +1,56 @@
+#ifndef PRESENT_H__
+#define PRESENT_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#include <stddef.h>
+#include <stdint.h>
+#include "source.h"
+
+#define PRESENT_DEFAULT_REFRESH 60
+// longest run of refreshes per frame told apart in the cadence histogram
+#define PRESENT_MAX_CADENCE 6
+
+    struct present_stats
+    {
+        size_t refreshes; // refreshes elapsed since the first frame
+        size_t repeats;   // refreshes that kept the previous frame on screen
+        size_t shown;     // frames that were on screen and were replaced since
+        size_t drops;     // frames replaced by a newer due frame before reaching the screen
+        size_t underruns; // refreshes where the next frame was due but the source had none
+        size_t late;      // frames shown one refresh or more after their due refresh
+        double judder_sum_ms; // |time on screen - timestamp duration| summed over shown frames
+        double judder_max_ms;
+        size_t cadence[PRESENT_MAX_CADENCE + 1]; // shown frames by refreshes on screen, [0] counts longer runs
+    };
+
+    struct present_scheduler;
+
+    // one stream on a <refresh_hz> display, its first frame (timestamp <first_pts_ns>)
+    // goes on screen at refresh 0; the refreshes are counted by the caller
+    struct present_scheduler *present_create(double refresh_hz, int64_t first_pts_ns);
+
+    // the frame to show at refresh <tick>: acquires while the next frame's timestamp is due,
+    // a frame is due from the refresh within a quarter period of its timestamp, so 24 fps
+    // on 60 Hz settles into 3:2 and rate pairs never tie on a boundary;
+    // SOURCE_OK: *frame is the new frame, the previous one was already released;
+    // SOURCE_AGAIN: keep showing *frame; SOURCE_EOF / SOURCE_ERROR as from the source.
+    // Holds at most one frame ahead, so with the one on screen two frames: the most any source
+    // lets a consumer hold, which each sizes its buffers or slots for
+    enum source_status present_pick(struct present_scheduler *ps, struct frame_source *src, uint64_t tick, void **frame);
+
+    void present_get_stats(struct present_scheduler *ps, struct present_stats *stats);
+
+    // cadence of <stats> as refreshes per frame and their share, e.g. "2 x50% 3 x50%" for 3:2
+    void present_format_cadence(const struct present_stats *stats, char *buf, size_t size);
+
+    // release the frame held ahead, NULL-safe; call before the source is destroyed
+    void present_destroy(struct present_scheduler *ps, struct frame_source *src);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // PRESENT_H__
@@ -0,0 +1,330 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <GLES3/gl3.h>
+#include "recorder.h"
+#include "glstate.h"
+#include "trace.h"
+#include "log.h"
+
+// slot life cycle, only the render thread touches GL:
+// FREE -> (glReadPixels + fence) READING -> (signalled, mapped) MAPPED
+//      -> (writer done with the mapping) WRITTEN -> (unmapped) FREE
+enum slot_state
+{
+    SLOT_FREE,
+    SLOT_READING,
+    SLOT_MAPPED,
+    SLOT_WRITTEN,
+};
+
+struct recorder_slot
+{
+    GLuint pbo;
+    GLsync fence;
+    enum slot_state state;
+    const unsigned char *pixels; // mapping handed to the writer, bottom-up RGBA
+    size_t seq;
+};
+
+struct recorder
+{
+    FILE *fp;
+    int y4m;
+    int width;
+    int height;
+    size_t size; // RGBA bytes per frame
+
+    struct recorder_slot slots[RECORDER_MAX_SLOTS];
+    int slot_count;
+    int next;   // slot of the next capture
+    int oldest; // oldest slot still READING, handed over in capture order
+    size_t seq;
+
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond_mapped;  // writer: a slot became MAPPED or stop
+    pthread_cond_t cond_written; // renderer: a slot became WRITTEN
+    int queue[RECORDER_MAX_SLOTS]; // MAPPED slots in frame order
+    int queue_head;
+    int queue_count;
+    int stop;
+    int write_error;
+
+    unsigned char *frame; // writer scratch, one converted frame
+    struct recorder_stats stats;
+};
+
+// BT.601 limited range, the usual Y4M interpretation
+static void rgba_to_yuv444(const unsigned char *rgba, int width, int height, unsigned char *out)
+{
+    unsigned char *y_plane = out;
+    unsigned char *u_plane = out + (size_t)width * height;
+    unsigned char *v_plane = u_plane + (size_t)width * height;
+    for (int row = 0; row < height; ++row)
+    {
+        // GL rows start at the bottom
+        const unsigned char *src = rgba + (size_t)(height - 1 - row) * width * 4;
+        size_t o = (size_t)row * width;
+        for (int x = 0; x < width; ++x, src += 4, ++o)
+        {
+            int r = src[0], g = src[1], b = src[2];
+            y_plane[o] = ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+            u_plane[o] = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+            v_plane[o] = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+        }
+    }
+}
+
+static void rgba_to_rgb24(const unsigned char *rgba, int width, int height, unsigned char *out)
+{
+    for (int row = 0; row < height; ++row)
+    {
+        const unsigned char *src = rgba + (size_t)(height - 1 - row) * width * 4;
+        unsigned char *dst = out + (size_t)row * width * 3;
+        for (int x = 0; x < width; ++x, src += 4, dst += 3)
+        {
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+        }
+    }
+}
+
+static void *writer_thread(void *arg)
+{
+    struct recorder *rec = arg;
+    size_t out_size = (size_t)rec->width * rec->height * 3;
+
+    trace_thread_name("recorder");
+    pthread_mutex_lock(&rec->mutex);
+    for (;;)
+    {
+        while (!rec->stop && rec->queue_count == 0)
+            pthread_cond_wait(&rec->cond_mapped, &rec->mutex);
+        if (rec->queue_count == 0)
+            break;
+        struct recorder_slot *slot = &rec->slots[rec->queue[rec->queue_head]];
+        pthread_mutex_unlock(&rec->mutex);
+
+        TRACE_SCOPE("record_write");
+        if (rec->y4m)
+            rgba_to_yuv444(slot->pixels, rec->width, rec->height, rec->frame);
+        else
+            rgba_to_rgb24(slot->pixels, rec->width, rec->height, rec->frame);
+        int ok = 1;
+        if (rec->y4m && fputs("FRAME\n", rec->fp) == EOF)
+            ok = 0;
+        if (ok && fwrite(rec->frame, 1, out_size, rec->fp) != out_size)
+            ok = 0;
+
+        pthread_mutex_lock(&rec->mutex);
+        if (!ok && !rec->write_error)
+        {
+            logerror("recorder: write failed");
+            rec->write_error = 1;
+        }
+        if (ok)
+            ++rec->stats.written;
+        slot->state = SLOT_WRITTEN;
+        rec->queue_head = (rec->queue_head + 1) % RECORDER_MAX_SLOTS;
+        --rec->queue_count;
+        pthread_cond_signal(&rec->cond_written);
+    }
+    pthread_mutex_unlock(&rec->mutex);
+
+    return NULL;
+}
+
+// READING -> MAPPED, queued for the writer; <wait> blocks on the fence
+static int hand_over(struct recorder *rec, int index, int wait)
+{
+    struct recorder_slot *slot = &rec->slots[index];
+    GLenum ret = glClientWaitSync(slot->fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? GL_TIMEOUT_IGNORED : 0);
+    if (ret == GL_TIMEOUT_EXPIRED)
+        return 0;
+    glDeleteSync(slot->fence);
+    slot->fence = 0;
+
+    glstate_bind_buffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+    slot->pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, rec->size, GL_MAP_READ_BIT);
+    glstate_bind_buffer(GL_PIXEL_PACK_BUFFER, GL_NONE);
+
+    pthread_mutex_lock(&rec->mutex);
+    if (slot->pixels)
+    {
+        slot->state = SLOT_MAPPED;
+        rec->queue[(rec->queue_head + rec->queue_count) % RECORDER_MAX_SLOTS] = index;
+        ++rec->queue_count;
+        pthread_cond_signal(&rec->cond_mapped);
+    }
+    else
+    {
+        logerror("recorder: glMapBufferRange failed, frame %zu lost", slot->seq);
+        slot->state = SLOT_FREE;
+    }
+    pthread_mutex_unlock(&rec->mutex);
+
+    rec->oldest = (rec->oldest + 1) % rec->slot_count;
+    return 1;
+}
+
+// WRITTEN -> FREE for every slot the writer finished
+static void reclaim(struct recorder *rec)
+{
+    for (int i = 0; i < rec->slot_count; ++i)
+    {
+        struct recorder_slot *slot = &rec->slots[i];
+        pthread_mutex_lock(&rec->mutex);
+        int written = slot->state == SLOT_WRITTEN;
+        pthread_mutex_unlock(&rec->mutex);
+        if (!written)
+            continue;
+
+        glstate_bind_buffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glstate_bind_buffer(GL_PIXEL_PACK_BUFFER, GL_NONE);
+        slot->pixels = NULL;
+        slot->state = SLOT_FREE;
+    }
+}
+
+struct recorder *recorder_create(const char *filename, int width, int height, double fps, int slots)
+{
+    if (slots < 2 || slots > RECORDER_MAX_SLOTS)
+    {
+        logerror("recorder slots %d out of range [2, %d]", slots, RECORDER_MAX_SLOTS);
+        return NULL;
+    }
+
+    struct recorder *rec = calloc(1, sizeof(*rec));
+    if (!rec)
+    {
+        logerror("calloc failed");
+        return NULL;
+    }
+    rec->width = width;
+    rec->height = height;
+    rec->size = (size_t)width * height * 4;
+    rec->slot_count = slots;
+    const char *ext = strrchr(filename, '.');
+    rec->y4m = ext && strcmp(ext, ".y4m") == 0;
+
+    rec->frame = malloc((size_t)width * height * 3);
+    rec->fp = fopen(filename, "wb");
+    if (!rec->frame || !rec->fp)
+    {
+        logerror("recorder: cannot open %s", filename);
+        if (rec->fp)
+            fclose(rec->fp);
+        free(rec->frame);
+        free(rec);
+        return NULL;
+    }
+    if (rec->y4m)
+    {
+        int fps_num = (int)((fps > 0 ? fps : 30) * 1000 + 0.5);
+        fprintf(rec->fp, "YUV4MPEG2 W%d H%d F%d:1000 Ip A1:1 C444\n", width, height, fps_num);
+    }
+
+    for (int i = 0; i < slots; ++i)
+    {
+        glGenBuffers(1, &rec->slots[i].pbo);
+        glstate_bind_buffer(GL_PIXEL_PACK_BUFFER, rec->slots[i].pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, rec->size, NULL, GL_STREAM_READ);
+    }
+    glstate_bind_buffer(GL_PIXEL_PACK_BUFFER, GL_NONE);
+
+    pthread_mutex_init(&rec->mutex, NULL);
+    pthread_cond_init(&rec->cond_mapped, NULL);
+    pthread_cond_init(&rec->cond_written, NULL);
+    if (pthread_create(&rec->thread, NULL, writer_thread, rec) != 0)
+    {
+        logerror("pthread_create failed");
+        pthread_cond_destroy(&rec->cond_written);
+        pthread_cond_destroy(&rec->cond_mapped);
+        pthread_mutex_destroy(&rec->mutex);
+        for (int i = 0; i < slots; ++i)
+            glDeleteBuffers(1, &rec->slots[i].pbo);
+        fclose(rec->fp);
+        free(rec->frame);
+        free(rec);
+        return NULL;
+    }
+
+    loginfo("recording %dx%d to %s (%s, %d slots)", width, height, filename, rec->y4m ? "y4m 444" : "raw rgb24", slots);
+    return rec;
+}
+
+void recorder_capture(struct recorder *rec)
+{
+    TRACE_SCOPE("record_capture");
+
+    reclaim(rec);
+
+    // pass finished readbacks on in capture order, without waiting
+    while (rec->slots[rec->oldest].state == SLOT_READING && hand_over(rec, rec->oldest, 0))
+        ;
+
+    struct recorder_slot *slot = &rec->slots[rec->next];
+    if (slot->state == SLOT_READING)
+    {
+        // the GPU is slot_count frames behind, this is the only place capture blocks on it
+        ++rec->stats.fence_waits;
+        hand_over(rec, rec->next, 1);
+    }
+    pthread_mutex_lock(&rec->mutex);
+    if (slot->state == SLOT_MAPPED)
+        ++rec->stats.writer_waits;
+    while (slot->state == SLOT_MAPPED)
+        pthread_cond_wait(&rec->cond_written, &rec->mutex);
+    pthread_mutex_unlock(&rec->mutex);
+    reclaim(rec);
+
+    glstate_bind_buffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+    glReadPixels(0, 0, rec->width, rec->height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    glstate_bind_buffer(GL_PIXEL_PACK_BUFFER, GL_NONE);
+    slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot->state = SLOT_READING;
+    slot->seq = rec->seq++;
+    ++rec->stats.captured;
+
+    rec->next = (rec->next + 1) % rec->slot_count;
+}
+
+void recorder_get_stats(struct recorder *rec, struct recorder_stats *stats)
+{
+    pthread_mutex_lock(&rec->mutex);
+    *stats = rec->stats;
+    pthread_mutex_unlock(&rec->mutex);
+}
+
+void recorder_destroy(struct recorder *rec)
+{
+    if (!rec)
+        return;
+
+    // remaining readbacks, oldest first so the file stays in order
+    while (rec->slots[rec->oldest].state == SLOT_READING)
+        hand_over(rec, rec->oldest, 1);
+
+    pthread_mutex_lock(&rec->mutex);
+    rec->stop = 1;
+    pthread_cond_signal(&rec->cond_mapped);
+    pthread_mutex_unlock(&rec->mutex);
+    pthread_join(rec->thread, NULL);
+    reclaim(rec);
+
+    for (int i = 0; i < rec->slot_count; ++i)
+        glDeleteBuffers(1, &rec->slots[i].pbo);
+    pthread_cond_destroy(&rec->cond_written);
+    pthread_cond_destroy(&rec->cond_mapped);
+    pthread_mutex_destroy(&rec->mutex);
+
+    loginfo("recorder: %zu frames captured, %zu written, %zu fence waits, %zu writer waits",
+        rec->stats.captured, rec->stats.written, rec->stats.fence_waits, rec->stats.writer_waits);
+    fclose(rec->fp);
+    free(rec->frame);
+    free(rec);
+}
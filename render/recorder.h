@@ -0,0 +1,41 @@
+#ifndef RECORDER_H__
+#define RECORDER_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#include <stddef.h>
+
+#define RECORDER_DEFAULT_SLOTS 4
+#define RECORDER_MAX_SLOTS 8
+
+    struct recorder_stats
+    {
+        size_t captured;     // readbacks issued
+        size_t written;      // frames on disk
+        size_t fence_waits;  // readback not finished when its slot came around again
+        size_t writer_waits; // writer thread still busy with the slot
+    };
+
+    struct recorder;
+
+    // record the bound read framebuffer (width x height, RGBA8) to <filename>:
+    // *.y4m as 4:4:4 BT.601 Y4M at <fps>, anything else as raw top-down rgb24;
+    // <slots> pack buffers in flight (2..RECORDER_MAX_SLOTS), the GL context must be current
+    struct recorder *recorder_create(const char *filename, int width, int height, double fps, int slots);
+
+    // after the draw and before the swap: start an asynchronous glReadPixels of
+    // this frame and hand earlier readbacks whose fence signalled to the writer thread
+    void recorder_capture(struct recorder *rec);
+
+    void recorder_get_stats(struct recorder *rec, struct recorder_stats *stats);
+
+    // finish every readback in flight, flush the file and join the writer
+    void recorder_destroy(struct recorder *rec);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // RECORDER_H__
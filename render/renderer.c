@@ -0,0 +1,123 @@
+#include <stdlib.h>
+#include "renderer.h"
+#include "log.h"
+
+struct renderer
+{
+    const struct pixel_format *fmt;
+    struct format_state state;
+    GLuint vao;
+    GLuint buffers[2]; // VBO, EBO
+};
+
+static void create_quad(struct renderer *r)
+{
+    glGenVertexArrays(1, &r->vao); // create VAO(vertex Array object)
+    glGenBuffers(2, r->buffers);   // create VBO(vertex buffer object) and EBO(element buffer object)
+
+    glstate_bind_vertex_array(r->vao); // bind VAO, for buffer config & vertex config
+
+    // vertex:                                   texture:
+    // +------------------------------+
+    // |                              |
+    // |      [2]------------[1]      |         [2]------------[1]
+    // |       |    (0, 0)    |       |          |              |
+    // |      [3]------------[0]      |         [3]------------[0]
+    // |                              |
+    // +------------------------------+
+    // (x, y, z, s, t), (x, y, z) for vertex location, (s, t) for texture
+    float vertices[] = {
+        -1.0f, 1.0f, 0.0f, 0.0f, 0.0f,
+        -1.0f, -1.0f, 0.0f, 0.0f, 1.0f,
+        1.0f, -1.0f, 0.0f, 1.0f, 1.0f,
+        1.0f, 1.0f, 0.0f, 1.0f, 0.0f};
+    glstate_bind_buffer(GL_ARRAY_BUFFER, r->buffers[0]); // pass vertex data (`vertices`) to GPU
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+    // two triagnle -> rectangle
+    unsigned int indices[] = {
+        0, 1, 2,
+        0, 2, 3};
+    glstate_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, r->buffers[1]); // pass index data (`indices`) to GPU
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+    // config vertex attribute 0 pointer, location
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (const void *)0);
+    glEnableVertexAttribArray(0);
+    // config index attribute 1 pointer, texture location
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (const void *)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    // clear binding for VAO
+    glstate_bind_buffer(GL_ARRAY_BUFFER, GL_NONE);
+    glstate_bind_vertex_array(GL_NONE);
+}
+
+struct renderer *renderer_create(const struct pixel_format *fmt, int width, int height, enum hdr_transfer transfer, void *frame)
+{
+    struct renderer *r = calloc(1, sizeof(*r));
+    if (!r)
+    {
+        logerror("calloc failed");
+        return NULL;
+    }
+    r->fmt = fmt;
+    r->state.transfer = transfer;
+
+    r->state.upload = upload_state_create();
+    if (!r->state.upload)
+    {
+        free(r);
+        return NULL;
+    }
+
+    create_quad(r);
+
+    fmt->init(&r->state, width, height);
+    if (fmt->init_shader(&r->state) != 0)
+    {
+        logerror("%s init_shader failed", fmt->name);
+        renderer_destroy(r);
+        return NULL;
+    }
+    fmt->init_texture(&r->state, frame);
+
+    return r;
+}
+
+void renderer_update(struct renderer *r, void *frame)
+{
+    r->fmt->update_texture(&r->state, frame);
+}
+
+void renderer_draw(struct renderer *r)
+{
+    // another renderer on this context may have drawn since, the state cache elides what still matches
+    glstate_use_program(r->state.program);
+    bind_upload_textures(r->state.upload);
+    glstate_bind_vertex_array(r->vao);
+    // draw rectangle
+    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+}
+
+struct upload_state *renderer_upload_state(struct renderer *r)
+{
+    return r->state.upload;
+}
+
+void renderer_destroy(struct renderer *r)
+{
+    if (!r)
+        return;
+
+    upload_state_destroy(r->state.upload);
+    if (r->state.texture_count > 0)
+        glDeleteTextures(r->state.texture_count, r->state.textures);
+    if (r->state.program)
+        glDeleteProgram(r->state.program);
+    glDeleteBuffers(2, r->buffers);
+    glDeleteVertexArrays(1, &r->vao);
+    // deleted objects may still be shadowed as bound
+    glstate_invalidate();
+    free(r);
+}
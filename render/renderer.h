@@ -0,0 +1,37 @@
+#ifndef RENDERER_H__
+#define RENDERER_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#include "format.h"
+#include "util.h"
+
+    // one stream drawn as a full screen quad: owns the format's program and textures,
+    // its upload state and the quad's vertex array; renderers share nothing, so each
+    // output or stream thread can drive its own on its own context
+    struct renderer;
+
+    // build the program, vertex array and textures of <fmt> at <width>x<height>, filled
+    // from <frame>; <transfer> is how 10/16-bit formats map to the display, the others
+    // ignore it; everything lives on the current context, which every call below needs
+    struct renderer *renderer_create(const struct pixel_format *fmt, int width, int height, enum hdr_transfer transfer, void *frame);
+
+    // upload <frame> as set up on the upload state, into an upload set on the upload thread
+    void renderer_update(struct renderer *r, void *frame);
+
+    // draw the last uploaded frame, or the bound upload set, into the current viewport
+    void renderer_draw(struct renderer *r);
+
+    // upload mode, dirty tiles, upload sets and stats of this renderer
+    struct upload_state *renderer_upload_state(struct renderer *r);
+
+    // NULL-safe, after any upload thread feeding it is destroyed
+    void renderer_destroy(struct renderer *r);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // RENDERER_H__
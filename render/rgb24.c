@@ -22,59 +22,39 @@ static char fragment_shader_src[] =
     "    FragColor = texture(rgb, TexCoord);  \n"
     "}                                        \n";
 
-static int width_;
-static int height_;
-static GLuint textures_[1];
-GLuint program_;
-
-void rgb24_init(int width, int height)
+void rgb24_init(struct format_state *st, int width, int height)
 {
-    width_ = width;
-    height_ = height;
+    st->width = width;
+    st->height = height;
 }
 
-int rgb24_init_shader()
+int rgb24_init_shader(struct format_state *st)
 {
-    GLuint vertex_shader = load_shader(GL_VERTEX_SHADER, vertex_shader_src);
-    if (vertex_shader == 0)
-    {
-        logerror("load_shader VERTEX failed");
-        return -1;
-    }
-
-    GLuint fragment_shader = load_shader(GL_FRAGMENT_SHADER, fragment_shader_src);
-    if (fragment_shader == 0)
-    {
-        logerror("load_shader FRAGMENT failed");
-        return -1;
-    }
-
-    program_ = link_program(vertex_shader, fragment_shader);
-    if (program_ == 0)
+    st->program = create_program(vertex_shader_src, fragment_shader_src);
+    if (st->program == 0)
     {
-        logerror("link_program failed");
+        logerror("create_program failed");
         return -1;
     }
 
-    glUseProgram(program_);
+    glstate_use_program(st->program);
 
-    glUniform1f(glGetUniformLocation(program_, "rgb"), 0);
+    glUniform1f(glGetUniformLocation(st->program, "rgb"), 0);
 
     glClearColor(1.0f, 1.0f, 1.0f, 0.0f);
 
     return 0;
 }
 
-void rgb24_init_texture(void *buffer)
+void rgb24_init_texture(struct format_state *st, void *buffer)
 {
-    glGenTextures(1, textures_);
+    st->texture_count = 1;
+    glGenTextures(st->texture_count, st->textures);
 
-    load_texture(GL_TEXTURE0, textures_[0], GL_RGB, width_, height_, buffer);
+    load_texture(st->upload, GL_TEXTURE0, st->textures[0], GL_RGB, st->width, st->height, buffer);
 }
 
-void rgb24_update_texture(void *buffer)
+void rgb24_update_texture(struct format_state *st, void *buffer)
 {
-    update_texture(GL_TEXTURE0, textures_[0], GL_RGB, width_, height_, buffer);
-    // use shader program
-    glUseProgram(program_);
+    update_texture(st->upload, GL_TEXTURE0, st->textures[0], GL_RGB, st->width, st->height, buffer);
 }
\ No newline at end of file
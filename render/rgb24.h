@@ -6,12 +6,12 @@ extern "C"
 {
 #endif // __cplusplus
 
-#include "util.h"
+#include "format.h"
 
-    void rgb24_init(int width, int height);
-    int rgb24_init_shader();
-    void rgb24_init_texture(void *buffer);
-    void rgb24_update_texture(void *buffer);
+    void rgb24_init(struct format_state *st, int width, int height);
+    int rgb24_init_shader(struct format_state *st);
+    void rgb24_init_texture(struct format_state *st, void *buffer);
+    void rgb24_update_texture(struct format_state *st, void *buffer);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,99 @@
+#ifndef SHM_RING_H__
+#define SHM_RING_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+// layout of a frame ring shared by one producer process and one renderer, in a POSIX
+// shm object or a memfd:
+//   [struct shm_ring_header][pad to data_offset][slot 0][slot 1]...[slot slot_count-1]
+// the producer fills slot head % slot_count, then publishes it by incrementing head;
+// the renderer releases slots in order by incrementing tail, so head - tail slots are in use
+
+#define SHM_RING_MAGIC 0x474e4952u // "RING"
+#define SHM_RING_VERSION 1
+// two frames held by the renderer (source.h) and one being filled
+#define SHM_RING_MIN_SLOTS 3
+#define SHM_RING_MAX_SLOTS 64
+#define SHM_RING_FORMAT_SIZE 16
+
+// shm_ring_header.flags
+#define SHM_RING_EOF 0x1      // the producer is done, nothing follows the published slots
+#define SHM_RING_DETACHED 0x2 // the renderer let go of the ring, nothing will be released
+
+    // written by the producer before it publishes the slot
+    struct shm_ring_slot
+    {
+        char format[SHM_RING_FORMAT_SIZE]; // format module name, e.g. "nv24"
+        uint32_t width;
+        uint32_t height;
+        uint64_t size;       // payload bytes
+        uint64_t seq;        // frame number, counting from 0
+        int64_t pts_ns;      // presentation time in the stream, -1 if unknown
+        int64_t publish_ns;  // CLOCK_MONOTONIC when published
+    };
+
+    struct shm_ring_header
+    {
+        // fixed once magic is set
+        uint32_t magic; // stored last with release order, the rest is valid once it reads back
+        uint32_t version;
+        uint32_t slot_count;
+        uint32_t reserved;
+        uint64_t slot_size;   // bytes per slot, a multiple of the page size
+        uint64_t data_offset; // of slot 0, a multiple of the page size
+        char format[SHM_RING_FORMAT_SIZE]; // stream format and geometry, every slot should match
+        uint32_t width;
+        uint32_t height;
+        uint32_t fps_num; // 0 if unknown
+        uint32_t fps_den;
+
+        // the two counters sit on their own cache lines, each is also its waiter's futex word
+        _Alignas(64) _Atomic uint32_t head; // slots published, the renderer waits on it
+        _Alignas(64) _Atomic uint32_t tail; // slots released, the producer waits on it when full
+        _Atomic uint32_t flags;
+        // set by a side about to sleep on head / tail, so publish and release only
+        // make the wake syscall when someone sleeps
+        _Atomic uint32_t head_waiting;
+        _Atomic uint32_t tail_waiting;
+
+        struct shm_ring_slot slots[SHM_RING_MAX_SLOTS];
+    };
+
+    static inline unsigned char *shm_ring_slot_data(struct shm_ring_header *hdr, uint32_t index)
+    {
+        return (unsigned char *)hdr + hdr->data_offset + (uint64_t)index * hdr->slot_size;
+    }
+
+    // block while *word == expected, for at most <timeout_ms>; the mapping is shared
+    // between processes, so no FUTEX_PRIVATE_FLAG
+    static inline void shm_ring_wait(_Atomic uint32_t *word, _Atomic uint32_t *waiting, uint32_t expected, int timeout_ms)
+    {
+        struct timespec ts = {timeout_ms / 1000, (timeout_ms % 1000) * 1000000L};
+        // seq_cst store then load, paired with the waker's store then load of waiting
+        atomic_store(waiting, 1);
+        if (atomic_load(word) == expected)
+            syscall(SYS_futex, (uint32_t *)word, FUTEX_WAIT, expected, &ts, NULL, 0);
+        atomic_store(waiting, 0);
+    }
+
+    // call after changing *word
+    static inline void shm_ring_wake(_Atomic uint32_t *word, _Atomic uint32_t *waiting)
+    {
+        if (atomic_load(waiting))
+            syscall(SYS_futex, (uint32_t *)word, FUTEX_WAKE, 1, NULL, NULL, 0);
+    }
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // SHM_RING_H__
@@ -0,0 +1,100 @@
+#ifndef SOURCE_H__
+#define SOURCE_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#include <stddef.h>
+#include <stdint.h>
+
+    // return values of frame_source.acquire
+    enum source_status
+    {
+        SOURCE_ERROR = -1,
+        SOURCE_OK = 0,
+        SOURCE_AGAIN, // no new frame yet, keep showing the last one
+        SOURCE_EOF,
+    };
+
+    // what the reader does when the queue is full
+    enum source_policy
+    {
+        SOURCE_POLICY_BLOCK,       // wait for the renderer to free a slot
+        SOURCE_POLICY_DROP_OLDEST, // discard the oldest queued frame
+        SOURCE_POLICY_LATEST,      // like DROP_OLDEST, and the renderer skips to the newest frame
+    };
+
+    struct source_stats
+    {
+        size_t frames_read;     // produced by the source
+        size_t frames_acquired; // handed to the renderer
+        size_t underruns;       // acquire found nothing to hand out
+        size_t drops;           // frames discarded by the policy
+    };
+
+    // where the frames are in the file
+    struct source_layout
+    {
+        size_t frame_size;
+        size_t offset; // bytes before the first frame, e.g. the Y4M stream header
+        int y4m;       // every frame is preceded by a "FRAME[ params]\n" marker
+        double fps;    // frame rate the timestamps are derived from, 0 if unknown
+    };
+
+    struct frame_source
+    {
+        size_t frame_size;
+        // readable while acquire may have a new frame, so an idle renderer can sleep in
+        // poll; -1 if the source cannot tell and has to be polled on a frame clock
+        int event_fd;
+        // presentation time of the frame handed out by the last successful acquire,
+        // counted from the start of the stream; -1 if the source has no timing
+        int64_t pts_ns;
+
+        // *frame stays valid until release, at most two frames may be held at a time
+        // so the renderer can keep its current frame until the next one is in
+        enum source_status (*acquire)(struct frame_source *src, void **frame);
+        void (*release)(struct frame_source *src, void *frame);
+        void (*get_stats)(struct frame_source *src, struct source_stats *stats);
+        // block up to <timeout_ms> until acquire may have a new frame, for a source without
+        // an event_fd; NULL if it has neither, acquire never runs dry then
+        void (*wait)(struct frame_source *src, int timeout_ms);
+        // position the next acquire at frame index, NULL if the source cannot seek
+        int (*seek)(struct frame_source *src, size_t index);
+        void (*destroy)(struct frame_source *src);
+
+        void *priv;
+    };
+
+    // first frame of the file, handed out forever
+    struct frame_source *source_still_create(const char *filename, const struct source_layout *layout);
+
+    // successive frames read by a background thread into a bounded queue
+    struct frame_source *source_stream_create(const char *filename, const struct source_layout *layout, int queue_depth, enum source_policy policy, int loop);
+
+    // frames point straight into a read-only mapping of the file, no copy;
+    // Y4M frame markers must be a bare "FRAME\n" so frames can be indexed
+    struct frame_source *source_mmap_create(const char *filename, const struct source_layout *layout, int loop);
+
+    // frames published by another process into a shared memory ring (shm_ring.h), handed
+    // out in place so they are uploaded straight from the slot, which goes back to the
+    // producer on release; <name> is a POSIX shm name ("/frames") or a path to the object,
+    // e.g. /proc/<pid>/fd/<n> of a memfd; LATEST skips to the newest published slot
+    struct frame_source *source_shm_create(const char *name, size_t frame_size, enum source_policy policy);
+
+    // stream format, geometry and rate from the header of the ring <name>
+    int source_shm_probe(const char *name, char *format, size_t format_size, int *width, int *height, double *fps);
+
+    // after SOURCE_AGAIN: sleep until acquire may have a new frame, on event_fd or the source's
+    // own wait, at most <timeout_ms>; -1 has no limit on an event_fd, a source's own wait
+    // still wakes now and then to notice the end of the stream
+    void source_wait(struct frame_source *src, int timeout_ms);
+
+    void source_destroy(struct frame_source *src);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // SOURCE_H__
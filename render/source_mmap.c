@@ -0,0 +1,211 @@
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "source.h"
+#include "y4m.h"
+#include "log.h"
+
+// frames prefetched ahead of the playhead
+#define MMAP_READAHEAD_FRAMES 4
+
+struct mmap_priv
+{
+    int fd;
+    unsigned char *data;
+    size_t length;
+    size_t page_size;
+    int loop;
+
+    size_t offset; // first frame (or its marker)
+    size_t marker; // bytes of FRAME marker before each frame
+    size_t stride; // marker + frame
+    size_t frame_count;
+    size_t next;          // index handed out by the next acquire
+    size_t position;      // frames played before the next one, keeps counting across loops
+    double fps;
+    size_t prefetched;    // frames [next, prefetched) already WILLNEED'ed
+    size_t dropped_until; // page aligned offset below which pages were DONTNEED'ed
+
+    struct source_stats stats;
+};
+
+static size_t page_floor(struct mmap_priv *priv, size_t offset)
+{
+    return offset / priv->page_size * priv->page_size;
+}
+
+static size_t frame_offset(struct mmap_priv *priv, size_t index)
+{
+    return priv->offset + index * priv->stride;
+}
+
+static void advise(struct mmap_priv *priv, size_t begin, size_t end, int advice)
+{
+    begin = page_floor(priv, begin);
+    if (end > priv->length)
+        end = priv->length;
+    if (end <= begin)
+        return;
+    if (madvise(priv->data + begin, end - begin, advice) != 0)
+        logwarn("madvise %d failed", advice);
+}
+
+static void prefetch(struct frame_source *src)
+{
+    struct mmap_priv *priv = src->priv;
+
+    size_t until = priv->next + MMAP_READAHEAD_FRAMES;
+    if (until > priv->frame_count)
+        until = priv->frame_count;
+    if (priv->prefetched < priv->next)
+        priv->prefetched = priv->next;
+    if (priv->prefetched >= until)
+        return;
+
+    advise(priv, frame_offset(priv, priv->prefetched), frame_offset(priv, until), MADV_WILLNEED);
+    priv->prefetched = until;
+}
+
+static enum source_status mmap_acquire(struct frame_source *src, void **frame)
+{
+    struct mmap_priv *priv = src->priv;
+
+    if (priv->next >= priv->frame_count)
+    {
+        if (!priv->loop)
+            return SOURCE_EOF;
+        priv->next = 0;
+        priv->prefetched = 0;
+        priv->dropped_until = 0;
+    }
+
+    // the renderer still holds the previous frame, release everything before it
+    if (priv->next >= 1)
+    {
+        size_t behind = page_floor(priv, frame_offset(priv, priv->next - 1));
+        if (behind > priv->dropped_until)
+        {
+            advise(priv, priv->dropped_until, behind, MADV_DONTNEED);
+            priv->dropped_until = behind;
+        }
+    }
+
+    unsigned char *data = priv->data + frame_offset(priv, priv->next);
+    if (priv->marker && memcmp(data, Y4M_FRAME_MAGIC "\n", priv->marker) != 0)
+    {
+        logerror("frame %zu: unexpected y4m frame marker", priv->next);
+        return SOURCE_ERROR;
+    }
+
+    *frame = data + priv->marker;
+    src->pts_ns = priv->fps > 0 ? (int64_t)(priv->position * 1e9 / priv->fps) : -1;
+    ++priv->position;
+    ++priv->next;
+    ++priv->stats.frames_read;
+    ++priv->stats.frames_acquired;
+
+    prefetch(src);
+
+    return SOURCE_OK;
+}
+
+static void mmap_release(struct frame_source *src, void *frame)
+{
+    (void)src;
+    (void)frame;
+}
+
+static void mmap_get_stats(struct frame_source *src, struct source_stats *stats)
+{
+    struct mmap_priv *priv = src->priv;
+    *stats = priv->stats;
+}
+
+static int mmap_seek(struct frame_source *src, size_t index)
+{
+    struct mmap_priv *priv = src->priv;
+
+    if (index >= priv->frame_count)
+    {
+        logerror("seek to frame %zu, only %zu frames", index, priv->frame_count);
+        return -1;
+    }
+
+    priv->next = index;
+    priv->position = index;
+    priv->prefetched = index;
+    priv->dropped_until = page_floor(priv, frame_offset(priv, index));
+    prefetch(src);
+
+    return 0;
+}
+
+static void mmap_destroy(struct frame_source *src)
+{
+    struct mmap_priv *priv = src->priv;
+    munmap(priv->data, priv->length);
+    close(priv->fd);
+    free(priv);
+    free(src);
+}
+
+struct frame_source *source_mmap_create(const char *filename, const struct source_layout *layout, int loop)
+{
+    size_t frame_size = layout->frame_size;
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        logerror("open %s failed", filename);
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < layout->offset + frame_size)
+    {
+        logerror("%s shorter than one frame (%zu bytes)", filename, frame_size);
+        close(fd);
+        return NULL;
+    }
+
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+    {
+        logerror("mmap %s failed", filename);
+        close(fd);
+        return NULL;
+    }
+
+    struct frame_source *src = calloc(1, sizeof(struct frame_source));
+    struct mmap_priv *priv = calloc(1, sizeof(struct mmap_priv));
+    priv->fd = fd;
+    priv->data = data;
+    priv->length = st.st_size;
+    priv->page_size = sysconf(_SC_PAGESIZE);
+    priv->loop = loop;
+    priv->offset = layout->offset;
+    priv->fps = layout->fps;
+    priv->marker = layout->y4m ? strlen(Y4M_FRAME_MAGIC "\n") : 0;
+    priv->stride = priv->marker + frame_size;
+    priv->frame_count = (st.st_size - layout->offset) / priv->stride;
+
+    src->frame_size = frame_size;
+    src->acquire = mmap_acquire;
+    src->release = mmap_release;
+    src->get_stats = mmap_get_stats;
+    // frames are always there, only a clock paces them
+    src->event_fd = -1;
+    src->pts_ns = -1;
+    src->seek = mmap_seek;
+    src->destroy = mmap_destroy;
+    src->priv = priv;
+
+    advise(priv, 0, priv->length, MADV_SEQUENTIAL);
+    prefetch(src);
+    loginfo("mapped %s, %zu frames", filename, priv->frame_count);
+
+    return src;
+}
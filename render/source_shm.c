@@ -0,0 +1,278 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "source.h"
+#include "shm_ring.h"
+#include "log.h"
+
+// how long one wait for the producer lasts before checking again
+#define SHM_WAIT_MS 100
+// how long the first acquire waits for a first frame
+#define SHM_FIRST_FRAME_MS 10000
+
+struct shm_priv
+{
+    int fd;
+    struct shm_ring_header *hdr;
+    size_t length;
+    enum source_policy policy;
+
+    uint32_t first;    // tail when attached
+    uint32_t acquired; // slots handed out or dropped, the next acquire looks at this one
+    uint32_t released; // mirrors hdr->tail
+    unsigned char done[SHM_RING_MAX_SLOTS]; // released out of order, waiting for tail to reach them
+    int started;       // a frame was handed out, from then on an empty ring is an underrun
+    uint64_t mismatched;
+
+    struct source_stats stats;
+};
+
+// POSIX shm names are "/name", anything else with a '/' is a path such as /proc/<pid>/fd/<n>
+static int open_ring(const char *name)
+{
+    if (name[0] == '/' && !strchr(name + 1, '/'))
+        return shm_open(name, O_RDWR, 0);
+    return open(name, O_RDWR);
+}
+
+static struct shm_ring_header *map_ring(const char *name, int *fd_out, size_t *length_out)
+{
+    int fd = open_ring(name);
+    if (fd < 0)
+    {
+        logerror("open frame ring %s failed, is the producer running?", name);
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(struct shm_ring_header))
+    {
+        logerror("%s is too small for a frame ring", name);
+        close(fd);
+        return NULL;
+    }
+
+    struct shm_ring_header *hdr = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (hdr == MAP_FAILED)
+    {
+        logerror("mmap %s failed", name);
+        close(fd);
+        return NULL;
+    }
+
+    if (__atomic_load_n(&hdr->magic, __ATOMIC_ACQUIRE) != SHM_RING_MAGIC || hdr->version != SHM_RING_VERSION ||
+        hdr->slot_count > SHM_RING_MAX_SLOTS ||
+        hdr->data_offset + (uint64_t)hdr->slot_count * hdr->slot_size > (uint64_t)st.st_size)
+    {
+        logerror("%s is not a version %d frame ring", name, SHM_RING_VERSION);
+        munmap(hdr, st.st_size);
+        close(fd);
+        return NULL;
+    }
+    if (hdr->slot_count < SHM_RING_MIN_SLOTS)
+    {
+        logerror("%s has %u slots, the renderer holds up to two while the producer fills one: need %d",
+            name, hdr->slot_count, SHM_RING_MIN_SLOTS);
+        munmap(hdr, st.st_size);
+        close(fd);
+        return NULL;
+    }
+
+    *fd_out = fd;
+    *length_out = st.st_size;
+    return hdr;
+}
+
+int source_shm_probe(const char *name, char *format, size_t format_size, int *width, int *height, double *fps)
+{
+    int fd;
+    size_t length;
+    struct shm_ring_header *hdr = map_ring(name, &fd, &length);
+    if (!hdr)
+        return -1;
+
+    snprintf(format, format_size, "%.*s", SHM_RING_FORMAT_SIZE, hdr->format);
+    *width = hdr->width;
+    *height = hdr->height;
+    *fps = hdr->fps_den > 0 ? (double)hdr->fps_num / hdr->fps_den : 0;
+
+    munmap(hdr, length);
+    close(fd);
+    return 0;
+}
+
+// hand slots back in ring order, tail only moves over a run of released ones
+static void release_slot(struct shm_priv *priv, uint32_t index)
+{
+    struct shm_ring_header *hdr = priv->hdr;
+    priv->done[index] = 1;
+
+    uint32_t released = priv->released;
+    while (released != priv->acquired && priv->done[released % hdr->slot_count])
+    {
+        priv->done[released % hdr->slot_count] = 0;
+        ++released;
+    }
+    if (released == priv->released)
+        return;
+
+    priv->released = released;
+    atomic_store(&hdr->tail, released);
+    shm_ring_wake(&hdr->tail, &hdr->tail_waiting);
+}
+
+// the slot's frame is what the renderer was set up for
+static int slot_matches(struct frame_source *src, const struct shm_ring_slot *slot)
+{
+    struct shm_ring_header *hdr = ((struct shm_priv *)src->priv)->hdr;
+    return strncmp(slot->format, hdr->format, SHM_RING_FORMAT_SIZE) == 0 && slot->width == hdr->width &&
+           slot->height == hdr->height && slot->size == src->frame_size;
+}
+
+static enum source_status shm_acquire(struct frame_source *src, void **frame)
+{
+    struct shm_priv *priv = src->priv;
+    struct shm_ring_header *hdr = priv->hdr;
+
+    for (int waited = 0;;)
+    {
+        uint32_t head = atomic_load(&hdr->head);
+        if (head == priv->acquired)
+        {
+            // flags before head again, so a frame published just before EOF is not lost
+            if ((atomic_load(&hdr->flags) & SHM_RING_EOF) && atomic_load(&hdr->head) == priv->acquired)
+                return SOURCE_EOF;
+            if (priv->started)
+            {
+                ++priv->stats.underruns;
+                return SOURCE_AGAIN;
+            }
+            // nothing shown yet, the renderer has nothing better to do than wait
+            if (waited >= SHM_FIRST_FRAME_MS)
+            {
+                logerror("no frame from the producer in %d ms", SHM_FIRST_FRAME_MS);
+                return SOURCE_ERROR;
+            }
+            shm_ring_wait(&hdr->head, &hdr->head_waiting, head, SHM_WAIT_MS);
+            waited += SHM_WAIT_MS;
+            continue;
+        }
+        priv->stats.frames_read = head - priv->first;
+
+        uint32_t index = priv->acquired % hdr->slot_count;
+        const struct shm_ring_slot *slot = &hdr->slots[index];
+        ++priv->acquired;
+
+        // skip to the newest published slot, the skipped ones go straight back
+        if (priv->policy == SOURCE_POLICY_LATEST && head - priv->acquired > 0)
+        {
+            ++priv->stats.drops;
+            release_slot(priv, index);
+            continue;
+        }
+        if (!slot_matches(src, slot))
+        {
+            if (priv->mismatched++ == 0)
+                logwarn("dropping frame %llu: %.*s %ux%u, %llu bytes, not the stream's %.*s %ux%u",
+                    (unsigned long long)slot->seq, SHM_RING_FORMAT_SIZE, slot->format, slot->width, slot->height,
+                    (unsigned long long)slot->size, SHM_RING_FORMAT_SIZE, hdr->format, hdr->width, hdr->height);
+            ++priv->stats.drops;
+            release_slot(priv, index);
+            continue;
+        }
+
+        *frame = shm_ring_slot_data(hdr, index);
+        src->pts_ns = slot->pts_ns;
+        priv->started = 1;
+        ++priv->stats.frames_acquired;
+        return SOURCE_OK;
+    }
+}
+
+static void shm_release(struct frame_source *src, void *frame)
+{
+    struct shm_priv *priv = src->priv;
+    struct shm_ring_header *hdr = priv->hdr;
+    size_t offset = (unsigned char *)frame - shm_ring_slot_data(hdr, 0);
+    release_slot(priv, offset / hdr->slot_size);
+}
+
+// sleep on head until the producer publishes past what was acquired, or marks the end
+static void shm_wait(struct frame_source *src, int timeout_ms)
+{
+    struct shm_priv *priv = src->priv;
+    struct shm_ring_header *hdr = priv->hdr;
+    if (!(atomic_load(&hdr->flags) & SHM_RING_EOF))
+        shm_ring_wait(&hdr->head, &hdr->head_waiting, priv->acquired, timeout_ms < 0 ? SHM_WAIT_MS : timeout_ms);
+}
+
+static void shm_get_stats(struct frame_source *src, struct source_stats *stats)
+{
+    struct shm_priv *priv = src->priv;
+    *stats = priv->stats;
+}
+
+static void shm_destroy(struct frame_source *src)
+{
+    struct shm_priv *priv = src->priv;
+    if (priv->mismatched > 0)
+        logwarn("dropped %llu frames not matching the stream", (unsigned long long)priv->mismatched);
+    atomic_fetch_or(&priv->hdr->flags, SHM_RING_DETACHED);
+    shm_ring_wake(&priv->hdr->tail, &priv->hdr->tail_waiting);
+    munmap(priv->hdr, priv->length);
+    close(priv->fd);
+    free(priv);
+    free(src);
+}
+
+struct frame_source *source_shm_create(const char *name, size_t frame_size, enum source_policy policy)
+{
+    struct shm_priv *priv = calloc(1, sizeof(*priv));
+    struct frame_source *src = calloc(1, sizeof(*src));
+    if (!priv || !src)
+    {
+        logerror("calloc failed");
+        free(priv);
+        free(src);
+        return NULL;
+    }
+
+    priv->hdr = map_ring(name, &priv->fd, &priv->length);
+    if (!priv->hdr)
+    {
+        free(priv);
+        free(src);
+        return NULL;
+    }
+    if (priv->hdr->slot_size < frame_size)
+    {
+        logerror("ring slots of %llu bytes cannot hold %zu byte frames", (unsigned long long)priv->hdr->slot_size, frame_size);
+        munmap(priv->hdr, priv->length);
+        close(priv->fd);
+        free(priv);
+        free(src);
+        return NULL;
+    }
+    // a renderer attaching late starts at the oldest slot still in the ring
+    priv->first = priv->acquired = priv->released = atomic_load(&priv->hdr->tail);
+    priv->policy = policy;
+
+    src->frame_size = frame_size;
+    src->acquire = shm_acquire;
+    src->release = shm_release;
+    src->get_stats = shm_get_stats;
+    // the producer only has the futex to wake
+    src->event_fd = -1;
+    src->wait = shm_wait;
+    src->pts_ns = -1;
+    src->seek = NULL;
+    src->destroy = shm_destroy;
+    src->priv = priv;
+
+    loginfo("frame ring %s: %u slots of %llu bytes", name, priv->hdr->slot_count, (unsigned long long)priv->hdr->slot_size);
+    return src;
+}
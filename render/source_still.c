@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include "source.h"
+#include "y4m.h"
+#include "log.h"
+
+struct still_priv
+{
+    void *buffer;
+    size_t acquired;
+};
+
+static enum source_status still_acquire(struct frame_source *src, void **frame)
+{
+    struct still_priv *priv = src->priv;
+    *frame = priv->buffer;
+    ++priv->acquired;
+    return SOURCE_OK;
+}
+
+static void still_release(struct frame_source *src, void *frame)
+{
+    (void)src;
+    (void)frame;
+}
+
+static void still_get_stats(struct frame_source *src, struct source_stats *stats)
+{
+    struct still_priv *priv = src->priv;
+    *stats = (struct source_stats){.frames_read = 1, .frames_acquired = priv->acquired};
+}
+
+static void still_destroy(struct frame_source *src)
+{
+    struct still_priv *priv = src->priv;
+    close(src->event_fd);
+    free(priv->buffer);
+    free(priv);
+    free(src);
+}
+
+struct frame_source *source_still_create(const char *filename, const struct source_layout *layout)
+{
+    size_t frame_size = layout->frame_size;
+
+    FILE *fp = fopen(filename, "rb");
+    if (!fp)
+    {
+        logerror("open %s failed", filename);
+        return NULL;
+    }
+
+    if (fseek(fp, layout->offset, SEEK_SET) != 0 || (layout->y4m && y4m_skip_frame_header(fp) != 0))
+    {
+        logerror("%s has no frame", filename);
+        fclose(fp);
+        return NULL;
+    }
+
+    struct frame_source *src = calloc(1, sizeof(struct frame_source));
+    struct still_priv *priv = calloc(1, sizeof(struct still_priv));
+    priv->buffer = calloc(1, frame_size);
+    if (fread(priv->buffer, 1, frame_size, fp) != frame_size)
+        logwarn("%s shorter than one frame (%zu bytes)", filename, frame_size);
+    fclose(fp);
+
+    src->frame_size = frame_size;
+    // never readable, there is nothing after the first frame
+    src->event_fd = eventfd(0, EFD_CLOEXEC);
+    src->pts_ns = 0;
+    src->acquire = still_acquire;
+    src->release = still_release;
+    src->get_stats = still_get_stats;
+    src->destroy = still_destroy;
+    src->priv = priv;
+
+    return src;
+}
+
+void source_wait(struct frame_source *src, int timeout_ms)
+{
+    if (src->event_fd >= 0)
+    {
+        struct pollfd pfd = {src->event_fd, POLLIN, 0};
+        poll(&pfd, 1, timeout_ms);
+    }
+    else if (src->wait)
+    {
+        src->wait(src, timeout_ms);
+    }
+}
+
+void source_destroy(struct frame_source *src)
+{
+    if (src)
+        src->destroy(src);
+}
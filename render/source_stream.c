@@ -0,0 +1,299 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include "source.h"
+#include "y4m.h"
+#include "log.h"
+#include "trace.h"
+
+// frames move free -> (reader) -> ready -> (renderer) -> free;
+// queue_depth + 3 buffers so the reader can hold one and the renderer two (see source.h) while the queue is full
+struct stream_priv
+{
+    FILE *fp;
+    struct source_layout layout;
+    enum source_policy policy;
+    int loop;
+
+    void **buffers;
+    int buffer_count;
+
+    void **free_list; // stack
+    int free_count;
+
+    void **ready; // ring, oldest at ready_head
+    int64_t *ready_pts;
+    int ready_head;
+    int ready_count;
+    int queue_depth;
+
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond_free;
+    pthread_cond_t cond_ready;
+    int stop;
+    int eof;
+    int started; // a frame was handed out, empty queue counts as underrun from now on
+
+    struct source_stats stats;
+};
+
+static void *ready_pop(struct stream_priv *priv)
+{
+    void *frame = priv->ready[priv->ready_head];
+    priv->ready_head = (priv->ready_head + 1) % priv->queue_depth;
+    --priv->ready_count;
+    return frame;
+}
+
+static void ready_push(struct stream_priv *priv, void *frame, int64_t pts)
+{
+    priv->ready[(priv->ready_head + priv->ready_count) % priv->queue_depth] = frame;
+    priv->ready_pts[(priv->ready_head + priv->ready_count) % priv->queue_depth] = pts;
+    ++priv->ready_count;
+}
+
+// 0 on success, 1 at end of file, -1 on error
+static int read_frame(struct frame_source *src, void *frame)
+{
+    struct stream_priv *priv = src->priv;
+
+    if (priv->layout.y4m)
+    {
+        int ret = y4m_skip_frame_header(priv->fp);
+        if (ret != 0)
+            return ret;
+    }
+
+    if (fread(frame, 1, src->frame_size, priv->fp) != src->frame_size)
+        return ferror(priv->fp) ? -1 : 1;
+
+    return 0;
+}
+
+static void *reader_thread(void *arg)
+{
+    struct frame_source *src = arg;
+    struct stream_priv *priv = src->priv;
+
+    trace_thread_name("reader");
+    for (;;)
+    {
+        TRACE_BEGIN(wait_begin);
+        pthread_mutex_lock(&priv->mutex);
+        while (!priv->stop && (priv->ready_count == priv->queue_depth || priv->free_count == 0))
+        {
+            if (priv->policy != SOURCE_POLICY_BLOCK && priv->ready_count == priv->queue_depth)
+            {
+                priv->free_list[priv->free_count++] = ready_pop(priv);
+                ++priv->stats.drops;
+                continue;
+            }
+            pthread_cond_wait(&priv->cond_free, &priv->mutex);
+        }
+        if (priv->stop)
+        {
+            pthread_mutex_unlock(&priv->mutex);
+            break;
+        }
+        void *frame = priv->free_list[--priv->free_count];
+        pthread_mutex_unlock(&priv->mutex);
+        TRACE_END("wait_free", wait_begin);
+
+        TRACE_BEGIN(read_begin);
+        int ret = read_frame(src, frame);
+        if (ret == 1 && priv->loop)
+        {
+            fseek(priv->fp, priv->layout.offset, SEEK_SET);
+            ret = read_frame(src, frame);
+        }
+        TRACE_END("read", read_begin);
+
+        pthread_mutex_lock(&priv->mutex);
+        if (ret != 0)
+        {
+            if (ret < 0)
+                logerror("read failed");
+            priv->free_list[priv->free_count++] = frame;
+            priv->eof = 1;
+            pthread_cond_broadcast(&priv->cond_ready);
+            pthread_mutex_unlock(&priv->mutex);
+            eventfd_write(src->event_fd, 1);
+            break;
+        }
+        // numbered in file order across loops, dropped frames keep their slot in time
+        size_t index = priv->stats.frames_read++;
+        ready_push(priv, frame, priv->layout.fps > 0 ? (int64_t)(index * 1e9 / priv->layout.fps) : -1);
+        pthread_cond_signal(&priv->cond_ready);
+        pthread_mutex_unlock(&priv->mutex);
+        eventfd_write(src->event_fd, 1);
+    }
+
+    return NULL;
+}
+
+static enum source_status stream_acquire(struct frame_source *src, void **frame)
+{
+    struct stream_priv *priv = src->priv;
+    enum source_status status = SOURCE_OK;
+
+    pthread_mutex_lock(&priv->mutex);
+
+    // startup is not an underrun, the renderer needs a first frame to size its textures
+    while (!priv->started && priv->ready_count == 0 && !priv->eof)
+        pthread_cond_wait(&priv->cond_ready, &priv->mutex);
+
+    if (priv->ready_count == 0)
+    {
+        if (priv->eof)
+        {
+            status = SOURCE_EOF;
+        }
+        else
+        {
+            // caught up, a poll on event_fd sleeps until the reader pushes again
+            eventfd_t count;
+            eventfd_read(src->event_fd, &count);
+            ++priv->stats.underruns;
+            status = SOURCE_AGAIN;
+        }
+    }
+    else
+    {
+        if (priv->policy == SOURCE_POLICY_LATEST)
+        {
+            while (priv->ready_count > 1)
+            {
+                priv->free_list[priv->free_count++] = ready_pop(priv);
+                ++priv->stats.drops;
+            }
+            pthread_cond_signal(&priv->cond_free);
+        }
+        src->pts_ns = priv->ready_pts[priv->ready_head];
+        *frame = ready_pop(priv);
+        ++priv->stats.frames_acquired;
+        priv->started = 1;
+    }
+
+    pthread_mutex_unlock(&priv->mutex);
+
+    return status;
+}
+
+static void stream_release(struct frame_source *src, void *frame)
+{
+    struct stream_priv *priv = src->priv;
+
+    pthread_mutex_lock(&priv->mutex);
+    priv->free_list[priv->free_count++] = frame;
+    pthread_cond_signal(&priv->cond_free);
+    pthread_mutex_unlock(&priv->mutex);
+}
+
+static void stream_get_stats(struct frame_source *src, struct source_stats *stats)
+{
+    struct stream_priv *priv = src->priv;
+
+    pthread_mutex_lock(&priv->mutex);
+    *stats = priv->stats;
+    pthread_mutex_unlock(&priv->mutex);
+}
+
+static void stream_destroy(struct frame_source *src)
+{
+    struct stream_priv *priv = src->priv;
+
+    pthread_mutex_lock(&priv->mutex);
+    priv->stop = 1;
+    pthread_cond_broadcast(&priv->cond_free);
+    pthread_mutex_unlock(&priv->mutex);
+    pthread_join(priv->thread, NULL);
+
+    pthread_cond_destroy(&priv->cond_ready);
+    pthread_cond_destroy(&priv->cond_free);
+    pthread_mutex_destroy(&priv->mutex);
+
+    close(src->event_fd);
+    for (int i = 0; i < priv->buffer_count; ++i)
+        free(priv->buffers[i]);
+    free(priv->buffers);
+    free(priv->free_list);
+    free(priv->ready);
+    free(priv->ready_pts);
+    fclose(priv->fp);
+    free(priv);
+    free(src);
+}
+
+struct frame_source *source_stream_create(const char *filename, const struct source_layout *layout, int queue_depth, enum source_policy policy, int loop)
+{
+    size_t frame_size = layout->frame_size;
+
+    if (queue_depth < 1)
+    {
+        logerror("invalid queue depth %d", queue_depth);
+        return NULL;
+    }
+
+    FILE *fp = fopen(filename, "rb");
+    if (!fp)
+    {
+        logerror("open %s failed", filename);
+        return NULL;
+    }
+    fseek(fp, layout->offset, SEEK_SET);
+
+    struct frame_source *src = calloc(1, sizeof(struct frame_source));
+    struct stream_priv *priv = calloc(1, sizeof(struct stream_priv));
+    priv->fp = fp;
+    priv->layout = *layout;
+    priv->policy = policy;
+    priv->loop = loop;
+    priv->queue_depth = queue_depth;
+    priv->buffer_count = queue_depth + 3;
+    priv->buffers = calloc(priv->buffer_count, sizeof(void *));
+    priv->free_list = calloc(priv->buffer_count, sizeof(void *));
+    priv->ready = calloc(queue_depth, sizeof(void *));
+    priv->ready_pts = calloc(queue_depth, sizeof(int64_t));
+    for (int i = 0; i < priv->buffer_count; ++i)
+    {
+        priv->buffers[i] = malloc(frame_size);
+        priv->free_list[priv->free_count++] = priv->buffers[i];
+    }
+    pthread_mutex_init(&priv->mutex, NULL);
+    pthread_cond_init(&priv->cond_free, NULL);
+    pthread_cond_init(&priv->cond_ready, NULL);
+
+    src->frame_size = frame_size;
+    // nonblocking, acquire drains it without waiting when the queue runs dry
+    src->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    src->pts_ns = -1;
+    src->acquire = stream_acquire;
+    src->release = stream_release;
+    src->get_stats = stream_get_stats;
+    src->destroy = stream_destroy;
+    src->priv = priv;
+
+    if (pthread_create(&priv->thread, NULL, reader_thread, src) != 0)
+    {
+        logerror("pthread_create failed");
+        pthread_cond_destroy(&priv->cond_ready);
+        pthread_cond_destroy(&priv->cond_free);
+        pthread_mutex_destroy(&priv->mutex);
+        close(src->event_fd);
+        for (int i = 0; i < priv->buffer_count; ++i)
+            free(priv->buffers[i]);
+        free(priv->buffers);
+        free(priv->free_list);
+        free(priv->ready);
+        free(priv->ready_pts);
+        fclose(fp);
+        free(priv);
+        free(src);
+        return NULL;
+    }
+
+    return src;
+}
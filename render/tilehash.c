@@ -0,0 +1,254 @@
+#include <string.h>
+#include <pthread.h>
+#include "tilehash.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TILEHASH_X86
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define TILEHASH_NEON
+#endif
+
+// Four 64-bit lanes consume 32 byte blocks, xxh3 style:
+//   dk = d[i] ^ key[i]
+//   acc[i] += lo32(dk) * hi32(dk) + d[i ^ 1]
+//   key[i] += key_step[i]
+// the keys advance per block, counted across rows, so the sum depends on where each block
+// sits: swapped or moved blocks hash differently; every kernel below implements exactly
+// this, the tail (< 32 bytes per row) is mixed in scalar.
+
+static const uint64_t keys_[4] = {
+    0xbe4ba423396cfeb8ULL,
+    0x1cad21f72c81017cULL,
+    0xdb979083e96dd4deULL,
+    0x1f67b3b7a4a44072ULL,
+};
+
+static const uint64_t key_steps_[4] = {
+    0x9fb21c651e98df25ULL,
+    0xd6e8feb86659fd93ULL,
+    0xa0761d6478bd642fULL,
+    0xe7037ed1a0b428dbULL,
+};
+
+static const uint64_t acc_init_[4] = {
+    0x9e3779b185ebca87ULL,
+    0xc2b2ae3d27d4eb4fULL,
+    0x165667b19e3779f9ULL,
+    0x85ebca77c2b2ae63ULL,
+};
+
+static uint64_t load64(const unsigned char *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint64_t mix_tail(uint64_t hash, const unsigned char *p, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        hash ^= p[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static uint64_t finalize(const uint64_t acc[4], uint64_t tail, size_t length)
+{
+    uint64_t h = length * 0x9e3779b185ebca87ULL ^ tail;
+    for (int i = 0; i < 4; ++i)
+    {
+        h ^= acc[i] + keys_[i];
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+    }
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+uint64_t tile_hash_reference(const unsigned char *data, size_t row_bytes, int rows, size_t stride)
+{
+    uint64_t acc[4];
+    uint64_t key[4];
+    memcpy(acc, acc_init_, sizeof(acc));
+    memcpy(key, keys_, sizeof(key));
+    uint64_t tail = 0xcbf29ce484222325ULL;
+    size_t blocks = row_bytes / 32;
+
+    for (int y = 0; y < rows; ++y)
+    {
+        const unsigned char *p = data + y * stride;
+        for (size_t b = 0; b < blocks; ++b, p += 32)
+        {
+            uint64_t d[4] = {load64(p), load64(p + 8), load64(p + 16), load64(p + 24)};
+            for (int i = 0; i < 4; ++i)
+            {
+                uint64_t dk = d[i] ^ key[i];
+                acc[i] += (dk & 0xffffffffULL) * (dk >> 32) + d[i ^ 1];
+                key[i] += key_steps_[i];
+            }
+        }
+        tail = mix_tail(tail, p, row_bytes - blocks * 32);
+    }
+
+    return finalize(acc, tail, row_bytes * rows);
+}
+
+#ifdef TILEHASH_X86
+static uint64_t tile_hash_sse2(const unsigned char *data, size_t row_bytes, int rows, size_t stride)
+{
+    __m128i acc0 = _mm_loadu_si128((const __m128i *)&acc_init_[0]);
+    __m128i acc1 = _mm_loadu_si128((const __m128i *)&acc_init_[2]);
+    __m128i key0 = _mm_loadu_si128((const __m128i *)&keys_[0]);
+    __m128i key1 = _mm_loadu_si128((const __m128i *)&keys_[2]);
+    const __m128i step0 = _mm_loadu_si128((const __m128i *)&key_steps_[0]);
+    const __m128i step1 = _mm_loadu_si128((const __m128i *)&key_steps_[2]);
+    uint64_t tail = 0xcbf29ce484222325ULL;
+    size_t blocks = row_bytes / 32;
+
+    for (int y = 0; y < rows; ++y)
+    {
+        const unsigned char *p = data + y * stride;
+        for (size_t b = 0; b < blocks; ++b, p += 32)
+        {
+            __m128i d0 = _mm_loadu_si128((const __m128i *)p);
+            __m128i d1 = _mm_loadu_si128((const __m128i *)(p + 16));
+            __m128i dk0 = _mm_xor_si128(d0, key0);
+            __m128i dk1 = _mm_xor_si128(d1, key1);
+            // lo32 * hi32 of each 64-bit lane
+            __m128i p0 = _mm_mul_epu32(dk0, _mm_srli_epi64(dk0, 32));
+            __m128i p1 = _mm_mul_epu32(dk1, _mm_srli_epi64(dk1, 32));
+            // swap the 64-bit lanes
+            __m128i s0 = _mm_shuffle_epi32(d0, _MM_SHUFFLE(1, 0, 3, 2));
+            __m128i s1 = _mm_shuffle_epi32(d1, _MM_SHUFFLE(1, 0, 3, 2));
+            acc0 = _mm_add_epi64(acc0, _mm_add_epi64(p0, s0));
+            acc1 = _mm_add_epi64(acc1, _mm_add_epi64(p1, s1));
+            key0 = _mm_add_epi64(key0, step0);
+            key1 = _mm_add_epi64(key1, step1);
+        }
+        tail = mix_tail(tail, p, row_bytes - blocks * 32);
+    }
+
+    uint64_t acc[4];
+    _mm_storeu_si128((__m128i *)&acc[0], acc0);
+    _mm_storeu_si128((__m128i *)&acc[2], acc1);
+    return finalize(acc, tail, row_bytes * rows);
+}
+
+__attribute__((target("avx2"))) static uint64_t tile_hash_avx2(const unsigned char *data, size_t row_bytes, int rows, size_t stride)
+{
+    __m256i acc = _mm256_loadu_si256((const __m256i *)acc_init_);
+    __m256i key = _mm256_loadu_si256((const __m256i *)keys_);
+    const __m256i step = _mm256_loadu_si256((const __m256i *)key_steps_);
+    uint64_t tail = 0xcbf29ce484222325ULL;
+    size_t blocks = row_bytes / 32;
+
+    for (int y = 0; y < rows; ++y)
+    {
+        const unsigned char *p = data + y * stride;
+        for (size_t b = 0; b < blocks; ++b, p += 32)
+        {
+            __m256i d = _mm256_loadu_si256((const __m256i *)p);
+            __m256i dk = _mm256_xor_si256(d, key);
+            __m256i prod = _mm256_mul_epu32(dk, _mm256_srli_epi64(dk, 32));
+            // swap the 64-bit lanes within each 128-bit half
+            __m256i swap = _mm256_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2));
+            acc = _mm256_add_epi64(acc, _mm256_add_epi64(prod, swap));
+            key = _mm256_add_epi64(key, step);
+        }
+        tail = mix_tail(tail, p, row_bytes - blocks * 32);
+    }
+
+    uint64_t out[4];
+    _mm256_storeu_si256((__m256i *)out, acc);
+    return finalize(out, tail, row_bytes * rows);
+}
+#endif // TILEHASH_X86
+
+#ifdef TILEHASH_NEON
+static uint64_t tile_hash_neon(const unsigned char *data, size_t row_bytes, int rows, size_t stride)
+{
+    uint64x2_t acc0 = vld1q_u64(&acc_init_[0]);
+    uint64x2_t acc1 = vld1q_u64(&acc_init_[2]);
+    uint64x2_t key0 = vld1q_u64(&keys_[0]);
+    uint64x2_t key1 = vld1q_u64(&keys_[2]);
+    const uint64x2_t step0 = vld1q_u64(&key_steps_[0]);
+    const uint64x2_t step1 = vld1q_u64(&key_steps_[2]);
+    uint64_t tail = 0xcbf29ce484222325ULL;
+    size_t blocks = row_bytes / 32;
+
+    for (int y = 0; y < rows; ++y)
+    {
+        const unsigned char *p = data + y * stride;
+        for (size_t b = 0; b < blocks; ++b, p += 32)
+        {
+            uint64x2_t d0 = vreinterpretq_u64_u8(vld1q_u8(p));
+            uint64x2_t d1 = vreinterpretq_u64_u8(vld1q_u8(p + 16));
+            uint64x2_t dk0 = veorq_u64(d0, key0);
+            uint64x2_t dk1 = veorq_u64(d1, key1);
+            uint64x2_t p0 = vmull_u32(vmovn_u64(dk0), vshrn_n_u64(dk0, 32));
+            uint64x2_t p1 = vmull_u32(vmovn_u64(dk1), vshrn_n_u64(dk1, 32));
+            acc0 = vaddq_u64(acc0, vaddq_u64(p0, vextq_u64(d0, d0, 1)));
+            acc1 = vaddq_u64(acc1, vaddq_u64(p1, vextq_u64(d1, d1, 1)));
+            key0 = vaddq_u64(key0, step0);
+            key1 = vaddq_u64(key1, step1);
+        }
+        tail = mix_tail(tail, p, row_bytes - blocks * 32);
+    }
+
+    uint64_t acc[4];
+    vst1q_u64(&acc[0], acc0);
+    vst1q_u64(&acc[2], acc1);
+    return finalize(acc, tail, row_bytes * rows);
+}
+#endif // TILEHASH_NEON
+
+struct tile_hash_kernel
+{
+    const char *name;
+    tile_hash_func func;
+};
+
+// kernels this build has and the CPU runs, best first, the reference last
+static struct tile_hash_kernel kernels_[4];
+static int kernel_count_;
+// renderers on several threads hash their first tiles at once
+static pthread_once_t select_once_ = PTHREAD_ONCE_INIT;
+
+static void select_kernel()
+{
+#if defined(TILEHASH_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        kernels_[kernel_count_++] = (struct tile_hash_kernel){"avx2", tile_hash_avx2};
+    kernels_[kernel_count_++] = (struct tile_hash_kernel){"sse2", tile_hash_sse2};
+#elif defined(TILEHASH_NEON)
+    kernels_[kernel_count_++] = (struct tile_hash_kernel){"neon", tile_hash_neon};
+#endif
+    kernels_[kernel_count_++] = (struct tile_hash_kernel){"scalar", tile_hash_reference};
+}
+
+uint64_t tile_hash(const unsigned char *data, size_t row_bytes, int rows, size_t stride)
+{
+    pthread_once(&select_once_, select_kernel);
+    return kernels_[0].func(data, row_bytes, rows, stride);
+}
+
+const char *tile_hash_kernel()
+{
+    pthread_once(&select_once_, select_kernel);
+    return kernels_[0].name;
+}
+
+tile_hash_func tile_hash_kernel_at(int index, const char **name)
+{
+    pthread_once(&select_once_, select_kernel);
+    if (index < 0 || index >= kernel_count_)
+        return NULL;
+    *name = kernels_[index].name;
+    return kernels_[index].func;
+}
\ No newline at end of file
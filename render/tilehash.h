@@ -0,0 +1,31 @@
+#ifndef TILEHASH_H__
+#define TILEHASH_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#include <stddef.h>
+#include <stdint.h>
+
+    // 64-bit hash of a rows x row_bytes rectangle whose rows are stride bytes apart;
+    // not cryptographic, only meant to spot changed tiles between frames.
+    // The AVX2, SSE2, NEON and scalar kernels return identical values.
+    uint64_t tile_hash(const unsigned char *data, size_t row_bytes, int rows, size_t stride);
+
+    // name of the kernel picked at runtime, for logging
+    const char *tile_hash_kernel();
+
+    typedef uint64_t (*tile_hash_func)(const unsigned char *data, size_t row_bytes, int rows, size_t stride);
+
+    // the scalar kernel, built everywhere: what the others must match bit for bit
+    uint64_t tile_hash_reference(const unsigned char *data, size_t row_bytes, int rows, size_t stride);
+
+    // kernels the CPU can run by index, best first and the reference last, NULL past the last
+    tile_hash_func tile_hash_kernel_at(int index, const char **name);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // TILEHASH_H__
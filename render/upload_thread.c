@@ -0,0 +1,283 @@
+#include <stdlib.h>
+#include <pthread.h>
+#include <GLES3/gl3.h>
+#include "upload_thread.h"
+#include "util.h"
+#include "trace.h"
+#include "log.h"
+
+// set life cycle:
+// FREE -> (worker) UPLOADING -> (upload fence) READY -> (present) SHOWN
+//      -> (next present, fence behind its draws) FREE
+// a READY set overtaken by a newer one before being shown goes straight back to FREE
+enum set_state
+{
+    SET_FREE,
+    SET_UPLOADING,
+    SET_READY,
+    SET_SHOWN,
+};
+
+struct upload_set
+{
+    enum set_state state;
+    GLsync fence; // FREE: draws that sampled it, READY: the upload
+    size_t seq;
+};
+
+struct upload_thread
+{
+    struct egl_context ctx; // the worker's, shares objects with the render context
+    struct upload_state *up;
+    upload_thread_fn fn;
+    void *arg;
+
+    struct upload_set sets[UPLOAD_MAX_SETS];
+    int set_count;
+    int shown; // set bound for drawing, -1 before the first present
+    size_t seq;
+
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond_job;  // worker: a job or stop
+    pthread_cond_t cond_done; // render: job finished, a set became READY, or the worker started
+    pthread_cond_t cond_free; // worker: a set became FREE or stop
+    void *job;                // frame waiting for or being uploaded
+    void *done;               // frame uploaded, not yet handed back by submit
+    int started;              // 1 running, -1 failed to make its context current
+    int stop;
+
+    struct upload_thread_stats stats;
+};
+
+static int find_set(struct upload_thread *ut, enum set_state state)
+{
+    int found = -1;
+    for (int i = 0; i < ut->set_count; ++i)
+    {
+        // newest of that state
+        if (ut->sets[i].state == state && (found < 0 || ut->sets[i].seq > ut->sets[found].seq))
+            found = i;
+    }
+    return found;
+}
+
+static void *worker_thread(void *p)
+{
+    struct upload_thread *ut = p;
+    trace_thread_name("upload");
+
+    int ok = egl_make_current(&ut->ctx) == 0;
+    pthread_mutex_lock(&ut->mutex);
+    ut->started = ok ? 1 : -1;
+    pthread_cond_broadcast(&ut->cond_done);
+    pthread_mutex_unlock(&ut->mutex);
+    if (!ok)
+        return NULL;
+
+    pthread_mutex_lock(&ut->mutex);
+    for (;;)
+    {
+        while (!ut->stop && !ut->job)
+            pthread_cond_wait(&ut->cond_job, &ut->mutex);
+        if (ut->stop)
+            break;
+
+        int set = find_set(ut, SET_FREE);
+        if (set < 0)
+            ++ut->stats.worker_waits;
+        while (!ut->stop && (set = find_set(ut, SET_FREE)) < 0)
+            pthread_cond_wait(&ut->cond_free, &ut->mutex);
+        if (ut->stop)
+            break;
+
+        void *frame = ut->job;
+        GLsync drawn = ut->sets[set].fence;
+        ut->sets[set].fence = 0;
+        ut->sets[set].state = SET_UPLOADING;
+        pthread_mutex_unlock(&ut->mutex);
+
+        TRACE_BEGIN(upload_begin);
+        // the draws that sampled this set are normally long done; waiting on the CPU
+        // also covers drivers that write texels on the CPU at glTexSubImage2D time
+        if (drawn)
+        {
+            glClientWaitSync(drawn, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            glDeleteSync(drawn);
+        }
+        set_upload_target(ut->up, set);
+        ut->fn(ut->arg, frame);
+        GLsync uploaded = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        // another context can only wait on a fence that reached the GPU
+        glFlush();
+        TRACE_END("upload_set", upload_begin);
+
+        pthread_mutex_lock(&ut->mutex);
+        ut->sets[set].fence = uploaded;
+        ut->sets[set].state = SET_READY;
+        ut->sets[set].seq = ++ut->seq;
+        ++ut->stats.uploads;
+        ut->done = frame;
+        ut->job = NULL;
+        pthread_cond_broadcast(&ut->cond_done);
+    }
+    pthread_mutex_unlock(&ut->mutex);
+
+    set_upload_target(ut->up, -1);
+    egl_destroy(&ut->ctx);
+
+    return NULL;
+}
+
+struct upload_thread *upload_thread_create(struct egl_context *render_ctx, struct upload_state *up, int sets, upload_thread_fn fn, void *arg)
+{
+    // one shown, one READY for the next present, one being filled
+    if (sets < 3 || sets > UPLOAD_MAX_SETS)
+    {
+        logerror("upload sets %d out of range [3, %d]", sets, UPLOAD_MAX_SETS);
+        return NULL;
+    }
+
+    struct upload_thread *ut = calloc(1, sizeof(*ut));
+    if (!ut)
+    {
+        logerror("calloc failed");
+        return NULL;
+    }
+    ut->up = up;
+    ut->fn = fn;
+    ut->arg = arg;
+    ut->set_count = sets;
+    ut->shown = -1;
+
+    if (create_upload_sets(up, sets) != 0 || egl_shared_create(&ut->ctx, render_ctx) != 0)
+    {
+        logerror("upload context setup failed");
+        free(ut);
+        return NULL;
+    }
+
+    pthread_mutex_init(&ut->mutex, NULL);
+    pthread_cond_init(&ut->cond_job, NULL);
+    pthread_cond_init(&ut->cond_done, NULL);
+    pthread_cond_init(&ut->cond_free, NULL);
+    if (pthread_create(&ut->thread, NULL, worker_thread, ut) != 0)
+    {
+        logerror("pthread_create failed");
+        egl_destroy(&ut->ctx);
+        free(ut);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&ut->mutex);
+    while (ut->started == 0)
+        pthread_cond_wait(&ut->cond_done, &ut->mutex);
+    pthread_mutex_unlock(&ut->mutex);
+    if (ut->started < 0)
+    {
+        logerror("upload thread failed to start");
+        pthread_join(ut->thread, NULL);
+        egl_destroy(&ut->ctx);
+        free(ut);
+        return NULL;
+    }
+    loginfo("upload thread: %d texture sets on a shared context", sets);
+
+    return ut;
+}
+
+void *upload_thread_submit(struct upload_thread *ut, void *frame)
+{
+    pthread_mutex_lock(&ut->mutex);
+    if (ut->job)
+        ++ut->stats.submit_waits;
+    while (ut->job)
+        pthread_cond_wait(&ut->cond_done, &ut->mutex);
+    void *done = ut->done;
+    ut->done = NULL;
+    ut->job = frame;
+    pthread_cond_signal(&ut->cond_job);
+    pthread_mutex_unlock(&ut->mutex);
+
+    return done;
+}
+
+void upload_thread_present(struct upload_thread *ut)
+{
+    pthread_mutex_lock(&ut->mutex);
+    while (ut->shown < 0 && find_set(ut, SET_READY) < 0)
+        pthread_cond_wait(&ut->cond_done, &ut->mutex);
+
+    int next = find_set(ut, SET_READY);
+    if (next < 0)
+    {
+        pthread_mutex_unlock(&ut->mutex);
+        return;
+    }
+
+    // never drawn, so nothing to fence
+    for (int i = 0; i < ut->set_count; ++i)
+    {
+        if (i != next && ut->sets[i].state == SET_READY)
+        {
+            glDeleteSync(ut->sets[i].fence);
+            ut->sets[i].fence = 0;
+            ut->sets[i].state = SET_FREE;
+            ++ut->stats.skipped;
+        }
+    }
+
+    GLsync uploaded = ut->sets[next].fence;
+    ut->sets[next].fence = 0;
+    ut->sets[next].state = SET_SHOWN;
+    if (ut->shown >= 0)
+    {
+        // behind every draw that sampled the old set
+        ut->sets[ut->shown].fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+        ut->sets[ut->shown].state = SET_FREE;
+    }
+    ut->shown = next;
+    pthread_cond_signal(&ut->cond_free);
+    pthread_mutex_unlock(&ut->mutex);
+
+    // the GPU, not this thread, waits for the upload
+    glWaitSync(uploaded, 0, GL_TIMEOUT_IGNORED);
+    glDeleteSync(uploaded);
+    bind_upload_set(ut->up, next);
+}
+
+void upload_thread_get_stats(struct upload_thread *ut, struct upload_thread_stats *stats)
+{
+    pthread_mutex_lock(&ut->mutex);
+    *stats = ut->stats;
+    pthread_mutex_unlock(&ut->mutex);
+}
+
+void upload_thread_destroy(struct upload_thread *ut)
+{
+    if (!ut)
+        return;
+
+    pthread_mutex_lock(&ut->mutex);
+    ut->stop = 1;
+    pthread_cond_signal(&ut->cond_job);
+    pthread_cond_signal(&ut->cond_free);
+    pthread_mutex_unlock(&ut->mutex);
+    pthread_join(ut->thread, NULL);
+
+    // shared objects, deleted from the render context
+    for (int i = 0; i < ut->set_count; ++i)
+    {
+        if (ut->sets[i].fence)
+            glDeleteSync(ut->sets[i].fence);
+    }
+    loginfo("upload thread: %zu uploads, %zu skipped, %zu submit waits, %zu worker waits",
+        ut->stats.uploads, ut->stats.skipped, ut->stats.submit_waits, ut->stats.worker_waits);
+
+    pthread_mutex_destroy(&ut->mutex);
+    pthread_cond_destroy(&ut->cond_job);
+    pthread_cond_destroy(&ut->cond_done);
+    pthread_cond_destroy(&ut->cond_free);
+    free(ut);
+}
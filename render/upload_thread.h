@@ -0,0 +1,51 @@
+#ifndef UPLOAD_THREAD_H__
+#define UPLOAD_THREAD_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#include <stddef.h>
+#include "egl.h"
+#include "util.h"
+
+#define UPLOAD_THREAD_DEFAULT_SETS 3
+
+    // fills the textures of the current upload set from <frame>, runs on the worker's context
+    typedef void (*upload_thread_fn)(void *arg, void *frame);
+
+    struct upload_thread_stats
+    {
+        size_t uploads;       // frames uploaded by the worker
+        size_t skipped;       // uploaded sets replaced by a newer one before being shown
+        size_t submit_waits;  // submit found the worker still busy with the previous frame
+        size_t worker_waits;  // no free set, the worker waited for the render thread
+    };
+
+    struct upload_thread;
+
+    // start a worker with its own context sharing objects with <render_ctx>, uploading
+    // through <fn> into <sets> (3..UPLOAD_MAX_SETS) texture sets that create_upload_sets
+    // adds to <up>; call on the render thread with <render_ctx> current, after the
+    // format's init_texture
+    struct upload_thread *upload_thread_create(struct egl_context *render_ctx, struct upload_state *up, int sets, upload_thread_fn fn, void *arg);
+
+    // hand <frame> to the worker; waits until the previous frame is uploaded and
+    // returns it (NULL if none), which the caller may then release
+    void *upload_thread_submit(struct upload_thread *ut, void *frame);
+
+    // bind the newest uploaded set for the next draw, the GPU waits on its upload fence
+    // (glWaitSync) and the set shown until now is handed back behind a fence of its draws;
+    // keeps the current set if nothing newer is ready, only the very first call blocks
+    void upload_thread_present(struct upload_thread *ut);
+
+    void upload_thread_get_stats(struct upload_thread *ut, struct upload_thread_stats *stats);
+
+    // join the worker, NULL-safe; the upload sets stay until upload_state_destroy
+    void upload_thread_destroy(struct upload_thread *ut);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // UPLOAD_THREAD_H__
@@ -1,117 +1,461 @@
 #include <stdlib.h>
+#include <string.h>
 #include "util.h"
+#include "tilehash.h"
 #include "log.h"
+#include "trace.h"
 
-static int check_error(GLuint x)
+struct pbo_slot
 {
-    void (*glGetiv)(GLuint x, GLenum pname, GLint *params);
-    void (*glGetInfoLog)(GLuint x, GLsizei bufSize, GLsizei *length, GLchar *infoLog);
-    void (*glDelete)(GLuint x);
-    GLenum pname_status;
+    GLuint pbo;
+    GLsizeiptr size;
+    GLsync fence; // signalled once the GPU has consumed the upload
+};
 
-    if (glIsShader(x))
+struct pbo_ring
+{
+    struct pbo_slot slots[UPLOAD_MAX_PBOS];
+    int next;
+};
+
+// last uploaded tile hashes of the plane on one texture unit
+struct dirty_plane
+{
+    GLuint texture;
+    GLsizei width;
+    GLsizei height;
+    int tiles_x;
+    int tiles_y;
+    uint64_t *hashes;
+    unsigned char *dirty;
+    int valid;
+};
+
+// what load_texture* made on each unit, mirrored by the upload sets
+struct plane_texture
+{
+    GLuint texture;
+    GLint internal_format;
+    GLenum format;
+    GLenum type;
+    GLsizei width;
+    GLsizei height;
+};
+
+struct upload_state
+{
+    enum upload_mode upload_mode;
+    int pbo_count;
+    struct pbo_ring pbo_rings[UPLOAD_MAX_PLANES];
+    int tile_size;
+    struct dirty_plane dirty_planes[UPLOAD_MAX_PLANES];
+    struct upload_stats stats; // atomic, see count_upload
+    struct plane_texture planes[UPLOAD_MAX_PLANES];
+    GLuint set_textures[UPLOAD_MAX_SETS][UPLOAD_MAX_PLANES];
+    int set_count;
+    int target_set; // copy written by update_texture*, -1 for the module's own textures
+    int bound_set;  // copy sampled by the next draw, -1 for the module's own textures
+};
+
+struct upload_state *upload_state_create()
+{
+    struct upload_state *up = calloc(1, sizeof(*up));
+    if (!up)
     {
-        glGetiv = glGetShaderiv;
-        glGetInfoLog = glGetShaderInfoLog;
-        glDelete = glDeleteShader;
-        pname_status = GL_COMPILE_STATUS;
+        logerror("calloc failed");
+        return NULL;
     }
-    else if (glIsProgram(x))
+    up->upload_mode = UPLOAD_DIRECT;
+    up->pbo_count = 3;
+    up->target_set = -1;
+    up->bound_set = -1;
+
+    return up;
+}
+
+static int is_integer_format(GLenum format)
+{
+    return format == GL_RED_INTEGER || format == GL_RG_INTEGER || format == GL_RGB_INTEGER || format == GL_RGBA_INTEGER;
+}
+
+void load_texture(struct upload_state *up, GLenum texture_id, GLuint texture, GLint format, GLsizei width, GLsizei height, void *buffer)
+{
+    load_texture_typed(up, texture_id, texture, format, format, GL_UNSIGNED_BYTE, width, height, buffer);
+}
+
+void load_texture_typed(struct upload_state *up, GLenum texture_id, GLuint texture, GLint internal_format, GLenum format, GLenum type, GLsizei width, GLsizei height, void *buffer)
+{
+    TRACE_SCOPE("load_texture");
+    // integer textures are incomplete with linear filtering, shaders filter them by hand
+    GLint filter = is_integer_format(format) ? GL_NEAREST : GL_LINEAR;
+
+    glstate_bind_buffer(GL_PIXEL_UNPACK_BUFFER, GL_NONE);
+    glstate_active_texture(texture_id);
+    glstate_bind_texture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, format, type, buffer);
+    // glGenerateMipmap(texture);
+    glstate_bind_texture(GL_TEXTURE_2D, GL_NONE);
+
+    int unit = texture_id - GL_TEXTURE0;
+    if (unit >= 0 && unit < UPLOAD_MAX_PLANES)
+        up->planes[unit] = (struct plane_texture){texture, internal_format, format, type, width, height};
+}
+
+// the upload thread's worker counts while the render thread takes the totals
+static void count_upload(struct upload_state *up, size_t uploaded, size_t skipped)
+{
+    if (uploaded)
+        __atomic_fetch_add(&up->stats.uploaded_bytes, uploaded, __ATOMIC_RELAXED);
+    if (skipped)
+        __atomic_fetch_add(&up->stats.skipped_bytes, skipped, __ATOMIC_RELAXED);
+}
+
+static int pixel_bytes(GLenum format, GLenum type)
+{
+    int components;
+    switch (format)
     {
-        glGetiv = glGetProgramiv;
-        glGetInfoLog = glGetProgramInfoLog;
-        glDelete = glDeleteProgram;
-        pname_status = GL_LINK_STATUS;
+    case GL_RED:
+    case GL_RED_INTEGER: components = 1; break;
+    case GL_RG:
+    case GL_RG_INTEGER: components = 2; break;
+    case GL_RGB:
+    case GL_RGB_INTEGER: components = 3; break;
+    case GL_RGBA:
+    case GL_RGBA_INTEGER: components = 4; break;
+    default:
+        logerror("unsupported format 0x%x", format);
+        return 0;
     }
-    else
+
+    switch (type)
     {
-        logerror("invalid x");
-        return -1;
+    case GL_UNSIGNED_BYTE: return components;
+    case GL_UNSIGNED_SHORT:
+    case GL_HALF_FLOAT: return components * 2;
+    default:
+        logerror("unsupported type 0x%x", type);
+        return 0;
+    }
+}
+
+static void update_texture_pbo(struct upload_state *up, GLenum texture_id, GLuint texture, GLenum format, GLenum type, GLsizei width, GLsizei height, void *buffer)
+{
+    TRACE_SCOPE("upload_pbo");
+    int unit = texture_id - GL_TEXTURE0;
+    if (unit < 0 || unit >= UPLOAD_MAX_PLANES)
+    {
+        logerror("texture unit %d out of range", unit);
+        return;
+    }
+
+    struct pbo_ring *ring = &up->pbo_rings[unit];
+    struct pbo_slot *slot = &ring->slots[ring->next];
+    ring->next = (ring->next + 1) % up->pbo_count;
+
+    GLsizeiptr size = (GLsizeiptr)width * height * pixel_bytes(format, type);
+
+    if (slot->pbo == 0)
+        glGenBuffers(1, &slot->pbo);
+    glstate_bind_buffer(GL_PIXEL_UNPACK_BUFFER, slot->pbo);
+
+    // the slot was last used up->pbo_count frames ago, normally long finished
+    if (slot->fence)
+    {
+        glClientWaitSync(slot->fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync(slot->fence);
+        slot->fence = 0;
+    }
+
+    if (slot->size < size)
+    {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+        slot->size = size;
+    }
+
+    // fenced above, so the driver need not synchronize or preserve the old contents
+    void *dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (!dst)
+    {
+        logerror("glMapBufferRange failed: 0x%x", glGetError());
+        return;
+    }
+    memcpy(dst, buffer, size);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    // sources from the bound PBO, returns without waiting for the transfer
+    glstate_active_texture(texture_id);
+    glstate_bind_texture(GL_TEXTURE_2D, texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, type, (const void *)0);
+
+    // the PBO stays bound, client memory uploads unbind it through the state cache
+    slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void update_texture(struct upload_state *up, GLenum texture_id, GLuint texture, GLint format, GLsizei width, GLsizei height, void *buffer)
+{
+    update_texture_typed(up, texture_id, texture, format, GL_UNSIGNED_BYTE, width, height, buffer);
+}
+
+// hash every tile and upload only the changed ones, merged into horizontal spans;
+// return 1 if everything changed and the caller should do a plain full upload
+static int update_texture_tiles(struct upload_state *up, GLenum texture_id, GLuint texture, GLenum format, GLenum type, GLsizei width, GLsizei height, void *buffer)
+{
+    TRACE_SCOPE("upload_tiles");
+    int unit = texture_id - GL_TEXTURE0;
+    if (unit < 0 || unit >= UPLOAD_MAX_PLANES)
+        return 1;
+
+    struct dirty_plane *plane = &up->dirty_planes[unit];
+    if (plane->texture != texture || plane->width != width || plane->height != height)
+    {
+        free(plane->hashes);
+        free(plane->dirty);
+        plane->texture = texture;
+        plane->width = width;
+        plane->height = height;
+        plane->tiles_x = (width + up->tile_size - 1) / up->tile_size;
+        plane->tiles_y = (height + up->tile_size - 1) / up->tile_size;
+        plane->hashes = calloc((size_t)plane->tiles_x * plane->tiles_y, sizeof(uint64_t));
+        plane->dirty = calloc((size_t)plane->tiles_x * plane->tiles_y, 1);
+        plane->valid = 0;
+    }
+
+    int bpp = pixel_bytes(format, type);
+    size_t stride = (size_t)width * bpp;
+    const unsigned char *data = buffer;
+    int dirty_count = 0;
+
+    for (int ty = 0; ty < plane->tiles_y; ++ty)
+    {
+        int y = ty * up->tile_size;
+        int rows = height - y < up->tile_size ? height - y : up->tile_size;
+        for (int tx = 0; tx < plane->tiles_x; ++tx)
+        {
+            int x = tx * up->tile_size;
+            int cols = width - x < up->tile_size ? width - x : up->tile_size;
+            int index = ty * plane->tiles_x + tx;
+            uint64_t hash = tile_hash(data + y * stride + (size_t)x * bpp, (size_t)cols * bpp, rows, stride);
+            plane->dirty[index] = !plane->valid || plane->hashes[index] != hash;
+            plane->hashes[index] = hash;
+            dirty_count += plane->dirty[index];
+        }
+    }
+    plane->valid = 1;
+
+    if (dirty_count == plane->tiles_x * plane->tiles_y)
+        return 1;
+
+    size_t uploaded = 0;
+    if (dirty_count == 0)
+    {
+        count_upload(up, 0, (size_t)width * height * bpp);
+        return 0;
     }
 
-    GLint success;
-    glGetiv(x, pname_status, &success);
-    if (!success)
+    glstate_bind_buffer(GL_PIXEL_UNPACK_BUFFER, GL_NONE);
+    glstate_active_texture(texture_id);
+    glstate_bind_texture(GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, width);
+
+    for (int ty = 0; ty < plane->tiles_y; ++ty)
     {
-        GLint info_len = 0;
-        glGetiv(x, GL_INFO_LOG_LENGTH, &info_len);
-        if (info_len > 1)
+        int y = ty * up->tile_size;
+        int rows = height - y < up->tile_size ? height - y : up->tile_size;
+        for (int tx = 0; tx < plane->tiles_x;)
         {
-            char *info_log = calloc(1, info_len);
-            glGetInfoLog(x, info_len, NULL, info_log);
-            logerror("failed: %s", info_log);
-            free(info_log);
+            if (!plane->dirty[ty * plane->tiles_x + tx])
+            {
+                ++tx;
+                continue;
+            }
+            int first = tx;
+            while (tx < plane->tiles_x && plane->dirty[ty * plane->tiles_x + tx])
+                ++tx;
+            int x = first * up->tile_size;
+            int cols = (tx * up->tile_size < width ? tx * up->tile_size : width) - x;
+            glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, cols, rows, format, type, data + y * stride + (size_t)x * bpp);
+            uploaded += (size_t)cols * rows * bpp;
         }
-        glDelete(x);
-        return -1;
     }
 
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    count_upload(up, uploaded, (size_t)width * height * bpp - uploaded);
     return 0;
 }
 
-GLuint load_shader(GLenum type, const char *shader_src)
+void update_texture_typed(struct upload_state *up, GLenum texture_id, GLuint texture, GLenum format, GLenum type, GLsizei width, GLsizei height, void *buffer)
 {
-    GLuint shader = glCreateShader(type);
-    if (shader == 0)
+    int unit = texture_id - GL_TEXTURE0;
+    if (up->target_set >= 0 && unit >= 0 && unit < UPLOAD_MAX_PLANES && up->set_textures[up->target_set][unit])
+        texture = up->set_textures[up->target_set][unit];
+
+    if (up->tile_size > 0 && update_texture_tiles(up, texture_id, texture, format, type, width, height, buffer) == 0)
+        return;
+
+    count_upload(up, (size_t)width * height * pixel_bytes(format, type), 0);
+
+    if (up->upload_mode == UPLOAD_PBO)
     {
-        logerror("glCreateShader failed");
-        return 0;
+        update_texture_pbo(up, texture_id, texture, format, type, width, height, buffer);
+        return;
     }
 
-    // load the shader source
-    glShaderSource(shader, 1, &shader_src, NULL);
-
-    // compile the shader
-    glCompileShader(shader);
+    TRACE_SCOPE("upload_direct");
+    glstate_bind_buffer(GL_PIXEL_UNPACK_BUFFER, GL_NONE);
+    glstate_active_texture(texture_id);
+    glstate_bind_texture(GL_TEXTURE_2D, texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, type, buffer);
+}
 
-    if (check_error(shader) != 0)
+void set_upload_mode(struct upload_state *up, enum upload_mode mode, int pbo_count)
+{
+    if (pbo_count < 1 || pbo_count > UPLOAD_MAX_PBOS)
     {
-        logerror("error accured");
-        return 0;
+        logwarn("pbo count %d out of range [1, %d], clamped", pbo_count, UPLOAD_MAX_PBOS);
+        pbo_count = pbo_count < 1 ? 1 : UPLOAD_MAX_PBOS;
     }
 
-    return shader;
+    up->upload_mode = mode;
+    up->pbo_count = pbo_count;
+    for (int i = 0; i < UPLOAD_MAX_PLANES; ++i)
+        up->pbo_rings[i].next = 0;
+}
+
+void set_dirty_tiles(struct upload_state *up, int tile_size)
+{
+    up->tile_size = tile_size > 0 ? tile_size : 0;
+    for (int i = 0; i < UPLOAD_MAX_PLANES; ++i)
+        up->dirty_planes[i].valid = 0;
+    if (up->tile_size)
+        loginfo("dirty tiles: %dx%d, hash kernel: %s", up->tile_size, up->tile_size, tile_hash_kernel());
+}
+
+// sibling formats (NV21, UYVY) reorder channels on the template texture's sampler
+static void copy_swizzle(GLenum texture_id, GLuint from, GLuint to)
+{
+    static const GLenum params[] = {GL_TEXTURE_SWIZZLE_R, GL_TEXTURE_SWIZZLE_G, GL_TEXTURE_SWIZZLE_B, GL_TEXTURE_SWIZZLE_A};
+    GLint swizzle[4];
+
+    glstate_active_texture(texture_id);
+    glstate_bind_texture(GL_TEXTURE_2D, from);
+    for (int i = 0; i < 4; ++i)
+        glGetTexParameteriv(GL_TEXTURE_2D, params[i], &swizzle[i]);
+    glstate_bind_texture(GL_TEXTURE_2D, to);
+    for (int i = 0; i < 4; ++i)
+        glTexParameteri(GL_TEXTURE_2D, params[i], swizzle[i]);
+    glstate_bind_texture(GL_TEXTURE_2D, GL_NONE);
 }
 
-GLuint link_program(GLuint vertex_shader, GLuint fragment_shader)
+int create_upload_sets(struct upload_state *up, int count)
 {
-    GLuint program = glCreateProgram();
-    if (program == 0)
+    if (count < 1 || count > UPLOAD_MAX_SETS)
     {
-        logerror("glCreateProgram failed");
-        return 0;
+        logerror("upload set count %d out of range [1, %d]", count, UPLOAD_MAX_SETS);
+        return -1;
     }
 
-    glAttachShader(program, vertex_shader);
-    glAttachShader(program, fragment_shader);
+    for (int set = 0; set < count; ++set)
+    {
+        for (int unit = 0; unit < UPLOAD_MAX_PLANES; ++unit)
+        {
+            struct plane_texture plane = up->planes[unit];
+            if (plane.texture == 0)
+                continue;
+            glGenTextures(1, &up->set_textures[set][unit]);
+            load_texture_typed(up, GL_TEXTURE0 + unit, up->set_textures[set][unit], plane.internal_format, plane.format,
+                plane.type, plane.width, plane.height, NULL);
+            copy_swizzle(GL_TEXTURE0 + unit, plane.texture, up->set_textures[set][unit]);
+            // load_texture_typed recorded the copy, the format's texture stays the template
+            up->planes[unit] = plane;
+        }
+    }
+    up->set_count = count;
+
+    return 0;
+}
 
-    glLinkProgram(program);
+void set_upload_target(struct upload_state *up, int set)
+{
+    up->target_set = set >= 0 && set < up->set_count ? set : -1;
+}
+
+void bind_upload_set(struct upload_state *up, int set)
+{
+    up->bound_set = set >= 0 && set < up->set_count ? set : -1;
+    bind_upload_textures(up);
+}
 
-    if (check_error(program) != 0)
+void bind_upload_textures(struct upload_state *up)
+{
+    for (int unit = 0; unit < UPLOAD_MAX_PLANES; ++unit)
     {
-        logerror("error occured");
-        return 0;
+        GLuint texture = up->bound_set >= 0 ? up->set_textures[up->bound_set][unit] : up->planes[unit].texture;
+        if (!texture)
+            continue;
+        glstate_active_texture(GL_TEXTURE0 + unit);
+        glstate_bind_texture(GL_TEXTURE_2D, texture);
     }
+}
 
-    return program;
+void take_upload_stats(struct upload_state *up, struct upload_stats *stats)
+{
+    stats->uploaded_bytes = __atomic_exchange_n(&up->stats.uploaded_bytes, 0, __ATOMIC_RELAXED);
+    stats->skipped_bytes = __atomic_exchange_n(&up->stats.skipped_bytes, 0, __ATOMIC_RELAXED);
 }
 
-void load_texture(GLenum texture_id, GLuint texture, GLint format, GLsizei width, GLsizei height, void *buffer)
+int upload_row_alignment(struct upload_state *up)
 {
-    glActiveTexture(texture_id);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, buffer);
-    // glGenerateMipmap(texture);
-    glBindTexture(GL_TEXTURE_2D, GL_NONE);
+    int alignment = 8;
+    for (int unit = 0; unit < UPLOAD_MAX_PLANES; ++unit)
+    {
+        const struct plane_texture *plane = &up->planes[unit];
+        if (!plane->texture)
+            continue;
+        int row_bytes = plane->width * pixel_bytes(plane->format, plane->type);
+        while (row_bytes % alignment)
+            alignment /= 2;
+    }
+    return alignment;
 }
 
-void update_texture(GLenum texture_id, GLuint texture, GLint format, GLsizei width, GLsizei height, void *buffer)
+void upload_state_destroy(struct upload_state *up)
 {
-    glActiveTexture(texture_id);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, buffer);
+    if (!up)
+        return;
+
+    for (int i = 0; i < UPLOAD_MAX_PLANES; ++i)
+    {
+        for (int j = 0; j < UPLOAD_MAX_PBOS; ++j)
+        {
+            struct pbo_slot *slot = &up->pbo_rings[i].slots[j];
+            if (slot->fence)
+                glDeleteSync(slot->fence);
+            if (slot->pbo)
+                glDeleteBuffers(1, &slot->pbo);
+        }
+    }
+    // a deleted PBO may still be shadowed as bound
+    glstate_invalidate();
+
+    for (int i = 0; i < UPLOAD_MAX_PLANES; ++i)
+    {
+        free(up->dirty_planes[i].hashes);
+        free(up->dirty_planes[i].dirty);
+    }
+
+    for (int set = 0; set < up->set_count; ++set)
+    {
+        for (int unit = 0; unit < UPLOAD_MAX_PLANES; ++unit)
+        {
+            if (up->set_textures[set][unit])
+                glDeleteTextures(1, &up->set_textures[set][unit]);
+        }
+    }
+    free(up);
 }
\ No newline at end of file
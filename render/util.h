@@ -9,14 +9,72 @@ extern "C"
 #include <GLES3/gl3.h>
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
+#include "glstate.h"
+#include "shader.h"
 
-    GLuint load_shader(GLenum type, const char *shader_src);
+#define UPLOAD_MAX_PLANES 4
+#define UPLOAD_MAX_PBOS 8
+#define UPLOAD_MAX_SETS 8
 
-    GLuint link_program(GLuint vertex_shader, GLuint fragment_shader);
+    enum upload_mode
+    {
+        UPLOAD_DIRECT, // glTexSubImage2D straight from client memory
+        UPLOAD_PBO,    // stage through a ring of GL_PIXEL_UNPACK_BUFFER per texture unit
+    };
 
-    void load_texture(GLenum texture_id, GLuint texture, GLint format, GLsizei width, GLsizei height, void *buffer);
+    // how one renderer's frames reach its textures: what load_texture* made, PBO rings,
+    // tile hashes, upload sets and stats; with upload sets the worker updates, the render thread binds
+    struct upload_state;
 
-    void update_texture(GLenum texture_id, GLuint texture, GLint format, GLsizei width, GLsizei height, void *buffer);
+    struct upload_state *upload_state_create();
+
+    void load_texture(struct upload_state *up, GLenum texture_id, GLuint texture, GLint format, GLsizei width, GLsizei height, void *buffer);
+
+    void update_texture(struct upload_state *up, GLenum texture_id, GLuint texture, GLint format, GLsizei width, GLsizei height, void *buffer);
+
+    // as above for non 8-bit planes, e.g. GL_R16UI / GL_RED_INTEGER / GL_UNSIGNED_SHORT
+    void load_texture_typed(struct upload_state *up, GLenum texture_id, GLuint texture, GLint internal_format, GLenum format, GLenum type, GLsizei width, GLsizei height, void *buffer);
+
+    void update_texture_typed(struct upload_state *up, GLenum texture_id, GLuint texture, GLenum format, GLenum type, GLsizei width, GLsizei height, void *buffer);
+
+    // bytes that went to glTexSubImage2D vs bytes the dirty tile check found unchanged
+    struct upload_stats
+    {
+        size_t uploaded_bytes;
+        size_t skipped_bytes;
+    };
+
+    // select how update_texture reaches the GPU, pbo_count is the ring depth for UPLOAD_PBO
+    void set_upload_mode(struct upload_state *up, enum upload_mode mode, int pbo_count);
+
+    // upload only tiles of tile_size x tile_size whose hash changed since the last frame, 0 disables
+    void set_dirty_tiles(struct upload_state *up, int tile_size);
+
+    // <count> copies of every texture load_texture* made so far, for filling one copy on
+    // another (shared) context while this one samples another; after the format's init_texture
+    int create_upload_sets(struct upload_state *up, int count);
+
+    // update_texture* write copy <set> instead of the format's texture, -1 restores
+    void set_upload_target(struct upload_state *up, int set);
+
+    // bind copy <set> on every unit in place of the format's textures, from now on
+    // bind_upload_textures binds it too; -1 goes back to the format's textures
+    void bind_upload_set(struct upload_state *up, int set);
+
+    // bind what the next draw samples on every unit, other renderers may have rebound them
+    void bind_upload_textures(struct upload_state *up);
+
+    // the totals since the previous call, zeroed as they are read; safe against
+    // update_texture* counting on the upload thread meanwhile
+    void take_upload_stats(struct upload_state *up, struct upload_stats *stats);
+
+    // largest GL_UNPACK_ALIGNMENT, up to 8, met by the rows of every plane load_texture* made;
+    // frames are tightly packed, so a larger one makes GL read past the end of each row
+    int upload_row_alignment(struct upload_state *up);
+
+    // free the PBO rings, tile hashes, upload sets and <up>, NULL-safe;
+    // needs the GL context still current, the format's own textures stay
+    void upload_state_destroy(struct upload_state *up);
 
 #ifdef __cplusplus
 }
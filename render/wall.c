@@ -0,0 +1,281 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <GLES3/gl3.h>
+#include "wall.h"
+#include "util.h"
+#include "trace.h"
+#include "log.h"
+
+#define WALL_MAX_PLANES 3
+
+static char vertex_shader_src[] =
+    "#version 320 es                                            \n"
+    "layout (location = 0) in vec2 aPos;                        \n" // unit quad, (0, 0) bottom left
+    "layout (location = 1) in vec4 aRect;                       \n" // per instance: x, y, w, h in NDC
+    "layout (location = 2) in float aLayer;                     \n" // per instance
+    "out vec2 TexCoord;                                         \n"
+    "flat out float Layer;                                      \n"
+    "void main()                                                \n"
+    "{                                                          \n"
+    "    gl_Position = vec4(aRect.xy + aPos * aRect.zw, 0.0, 1.0); \n"
+    "    TexCoord = vec2(aPos.x, 1.0 - aPos.y);                 \n" // frames are top-down
+    "    Layer = aLayer;                                        \n"
+    "}                                                          \n";
+
+// per format: planes and the body turning them into rgb, same matrices as the single stream modules
+struct wall_format
+{
+    const char *name;
+    int planes;
+    GLenum internal_formats[WALL_MAX_PLANES];
+    GLenum formats[WALL_MAX_PLANES];
+    int bytes[WALL_MAX_PLANES];
+    const char *to_rgb;
+};
+
+#define YUV_TO_RGB                                                         \
+    "    vec3 rgb = mat3(1,       1,        1,                          \n" \
+    "                    0,       -0.39465, 2.03211,                    \n" \
+    "                    1.13983, -0.58060, 0.0     ) * yuv;            \n"
+
+static const struct wall_format formats_[] = {
+    {"nv24", 2, {GL_R8, GL_RG8}, {GL_RED, GL_RG}, {1, 2},
+        "    vec3 yuv;                                                      \n"
+        "    yuv.x = texture(plane0, tc).r;                                 \n"
+        "    yuv.yz = texture(plane1, tc).rg - vec2(0.5, 0.5);              \n" YUV_TO_RGB},
+    {"i444", 3, {GL_R8, GL_R8, GL_R8}, {GL_RED, GL_RED, GL_RED}, {1, 1, 1},
+        "    vec3 yuv;                                                      \n"
+        "    yuv.x = texture(plane0, tc).r;                                 \n"
+        "    yuv.y = texture(plane1, tc).r - 0.5;                           \n"
+        "    yuv.z = texture(plane2, tc).r - 0.5;                           \n" YUV_TO_RGB},
+    {"rgb24", 1, {GL_RGB8}, {GL_RGB}, {3},
+        "    vec3 rgb = texture(plane0, tc).rgb;                            \n"},
+};
+
+struct wall
+{
+    const struct wall_format *fmt;
+    int width;
+    int height;
+    int streams;
+
+    GLuint textures[WALL_MAX_PLANES];
+    GLuint program;
+    GLuint vao;
+    GLuint buffers[3]; // quad, indices, instances
+};
+
+static const struct wall_format *find_format(const char *name)
+{
+    for (size_t i = 0; i < sizeof(formats_) / sizeof(formats_[0]); ++i)
+    {
+        if (strcmp(formats_[i].name, name) == 0)
+            return &formats_[i];
+    }
+    return NULL;
+}
+
+int wall_supports(const char *format)
+{
+    return find_format(format) != NULL;
+}
+
+static GLuint create_wall_program(const struct wall_format *fmt)
+{
+    char fragment_shader_src[2048];
+    snprintf(fragment_shader_src, sizeof(fragment_shader_src),
+        "#version 320 es                                                    \n"
+        "precision mediump float;                                           \n"
+        "precision mediump sampler2DArray;                                  \n"
+        "out vec4 FragColor;                                                \n"
+        "in vec2 TexCoord;                                                  \n"
+        "flat in float Layer;                                               \n"
+        "uniform sampler2DArray plane0;                                     \n"
+        "uniform sampler2DArray plane1;                                     \n"
+        "uniform sampler2DArray plane2;                                     \n"
+        "void main()                                                        \n"
+        "{                                                                  \n"
+        "    vec3 tc = vec3(TexCoord, Layer);                               \n"
+        "%s"
+        "    FragColor = vec4(rgb, 1.0);                                    \n"
+        "}                                                                  \n",
+        fmt->to_rgb);
+
+    GLuint program = create_program(vertex_shader_src, fragment_shader_src);
+    if (program == 0)
+        return 0;
+
+    glstate_use_program(program);
+    glUniform1i(glGetUniformLocation(program, "plane0"), 0);
+    glUniform1i(glGetUniformLocation(program, "plane1"), 1);
+    glUniform1i(glGetUniformLocation(program, "plane2"), 2);
+
+    return program;
+}
+
+// near-square grid, filled row by row from the top left
+static void layout_tiles(float *instances, int streams)
+{
+    int columns = 1;
+    while (columns * columns < streams)
+        ++columns;
+    int rows = (streams + columns - 1) / columns;
+    float w = 2.0f / columns, h = 2.0f / rows;
+    for (int i = 0; i < streams; ++i)
+    {
+        float *inst = instances + i * 5;
+        inst[0] = -1.0f + (i % columns) * w;
+        inst[1] = 1.0f - (i / columns + 1) * h;
+        inst[2] = w;
+        inst[3] = h;
+        inst[4] = i;
+    }
+}
+
+static void create_geometry(struct wall *wall)
+{
+    glGenVertexArrays(1, &wall->vao);
+    glGenBuffers(3, wall->buffers);
+    glstate_bind_vertex_array(wall->vao);
+
+    // [3]---[2]
+    //  |     |
+    // [0]---[1]
+    float quad[] = {
+        0.0f, 0.0f,
+        1.0f, 0.0f,
+        1.0f, 1.0f,
+        0.0f, 1.0f};
+    glstate_bind_buffer(GL_ARRAY_BUFFER, wall->buffers[0]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (const void *)0);
+    glEnableVertexAttribArray(0);
+
+    unsigned int indices[] = {
+        0, 1, 2,
+        0, 2, 3};
+    glstate_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, wall->buffers[1]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+    // (x, y, w, h, layer) per tile, advanced once per instance
+    float instances[WALL_MAX_STREAMS * 5];
+    layout_tiles(instances, wall->streams);
+    glstate_bind_buffer(GL_ARRAY_BUFFER, wall->buffers[2]);
+    glBufferData(GL_ARRAY_BUFFER, wall->streams * 5 * sizeof(float), instances, GL_STATIC_DRAW);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (const void *)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (const void *)(4 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+
+    glstate_bind_buffer(GL_ARRAY_BUFFER, GL_NONE);
+    glstate_bind_vertex_array(GL_NONE);
+}
+
+struct wall *wall_create(const char *format, int width, int height, int streams)
+{
+    const struct wall_format *fmt = find_format(format);
+    if (!fmt)
+    {
+        logerror("format %s cannot be shown on a wall", format);
+        return NULL;
+    }
+    GLint max_layers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+    if (streams < 1 || streams > WALL_MAX_STREAMS || streams > max_layers)
+    {
+        logerror("invalid stream count %d (max %d, %d layers)", streams, WALL_MAX_STREAMS, max_layers);
+        return NULL;
+    }
+
+    struct wall *wall = calloc(1, sizeof(*wall));
+    if (!wall)
+    {
+        logerror("calloc failed");
+        return NULL;
+    }
+    wall->fmt = fmt;
+    wall->width = width;
+    wall->height = height;
+    wall->streams = streams;
+
+    wall->program = create_wall_program(fmt);
+    if (wall->program == 0)
+    {
+        logerror("create_program failed");
+        free(wall);
+        return NULL;
+    }
+
+    // immutable storage for every layer up front, updates are sub-image only
+    glGenTextures(fmt->planes, wall->textures);
+    for (int p = 0; p < fmt->planes; ++p)
+    {
+        glstate_active_texture(GL_TEXTURE0 + p);
+        glstate_bind_texture(GL_TEXTURE_2D_ARRAY, wall->textures[p]);
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, fmt->internal_formats[p], width, height, streams);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+
+    create_geometry(wall);
+    loginfo("wall: %d x %s %dx%d, %d planes", streams, fmt->name, width, height, fmt->planes);
+
+    return wall;
+}
+
+int wall_update(struct wall *wall, void *const *frames)
+{
+    TRACE_SCOPE("wall_update");
+    // client memory, not a PBO left bound by the upload ring
+    glstate_bind_buffer(GL_PIXEL_UNPACK_BUFFER, GL_NONE);
+    int updated = 0;
+    size_t offset = 0;
+    for (int p = 0; p < wall->fmt->planes; ++p)
+    {
+        glstate_active_texture(GL_TEXTURE0 + p);
+        glstate_bind_texture(GL_TEXTURE_2D_ARRAY, wall->textures[p]);
+        updated = 0;
+        for (int i = 0; i < wall->streams; ++i)
+        {
+            if (!frames[i])
+                continue;
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, wall->width, wall->height, 1,
+                wall->fmt->formats[p], GL_UNSIGNED_BYTE, (const unsigned char *)frames[i] + offset);
+            ++updated;
+        }
+        offset += (size_t)wall->width * wall->height * wall->fmt->bytes[p];
+    }
+    return updated;
+}
+
+void wall_draw(struct wall *wall)
+{
+    // the arrays stay bound on units 0..planes-1, the state cache elides the rebinds
+    for (int p = 0; p < wall->fmt->planes; ++p)
+    {
+        glstate_active_texture(GL_TEXTURE0 + p);
+        glstate_bind_texture(GL_TEXTURE_2D_ARRAY, wall->textures[p]);
+    }
+    glstate_use_program(wall->program);
+    glstate_bind_vertex_array(wall->vao);
+    glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, wall->streams);
+}
+
+void wall_destroy(struct wall *wall)
+{
+    if (!wall)
+        return;
+
+    glDeleteTextures(wall->fmt->planes, wall->textures);
+    glDeleteBuffers(3, wall->buffers);
+    glDeleteVertexArrays(1, &wall->vao);
+    glDeleteProgram(wall->program);
+    // deleted objects may still be in the shadow
+    glstate_invalidate();
+    free(wall);
+}
@@ -0,0 +1,34 @@
+#ifndef WALL_H__
+#define WALL_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#define WALL_MAX_STREAMS 256
+
+    struct wall;
+
+    // <streams> feeds of one 4:4:4 format (nv24, i444 or rgb24) and size, kept as
+    // layers of one GL_TEXTURE_2D_ARRAY per plane and tiled on a near-square grid;
+    // the GL context must be current
+    struct wall *wall_create(const char *format, int width, int height, int streams);
+
+    // nonzero if <format> can be shown on a wall
+    int wall_supports(const char *format);
+
+    // replace the layer of every stream i with frames[i] != NULL, the others keep their
+    // last frame; uploads go plane by plane so each array is bound once; returns the count
+    int wall_update(struct wall *wall, void *const *frames);
+
+    // every tile in one instanced draw, tile rectangle and layer are per-instance attributes
+    void wall_draw(struct wall *wall);
+
+    // NULL-safe, needs the context still current
+    void wall_destroy(struct wall *wall);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // WALL_H__
@@ -0,0 +1,118 @@
+#include "log.h"
+#include "x11.h"
+#include "trace.h"
+
+int x11_window_create(struct x11_context *ctx, int width, int height, const char *title)
+{
+    if (!ctx)
+    {
+        logerror("invalid x11_context");
+        return -1;
+    }
+
+    ctx->display = XOpenDisplay(NULL);
+    if (ctx->display == NULL)
+    {
+        logerror("XOpenDisplay failed");
+        return -1;
+    }
+
+    Window root = XDefaultRootWindow(ctx->display);
+    XSetWindowAttributes swa = {.event_mask = ExposureMask | StructureNotifyMask | KeyPressMask};
+    ctx->win = XCreateWindow(
+        ctx->display, root,
+        0, 0, width, height, 0,
+        CopyFromParent, InputOutput,
+        CopyFromParent, CWEventMask,
+        &swa);
+
+    ctx->s_wm_delete_message = XInternAtom(ctx->display, "WM_DELETE_WINDOW", False);
+    XSetWMProtocols(ctx->display, ctx->win, &ctx->s_wm_delete_message, 1);
+
+    XSetWindowAttributes xattr = {.override_redirect = 0};
+    XChangeWindowAttributes(ctx->display, ctx->win, CWOverrideRedirect, &xattr);
+
+    XWMHints hints = {.input = 1, .flags = InputHint};
+    XSetWMHints(ctx->display, ctx->win, &hints);
+
+    // show window
+    XMapWindow(ctx->display, ctx->win);
+    XStoreName(ctx->display, ctx->win, title);
+
+    // get identifiers for the provided atom name strings
+    Atom wm_state = XInternAtom(ctx->display, "_NET_WM_STATE", 0);
+
+    XEvent xev = {.type = ClientMessage};
+    xev.xclient.window = ctx->win;
+    xev.xclient.message_type = wm_state;
+    xev.xclient.format = 32;
+    xev.xclient.data.l[0] = 1;
+    xev.xclient.data.l[0] = 0;
+    XSendEvent(ctx->display, DefaultRootWindow(ctx->display), 0, SubstructureNotifyMask, &xev);
+
+    return 0;
+}
+
+int x11_window_poll(struct x11_context *ctx)
+{
+    XEvent xev;
+    int events = 0;
+
+    while (XPending(ctx->display))
+    {
+        XNextEvent(ctx->display, &xev);
+        switch (xev.type)
+        {
+        case KeyPress:
+        {
+            KeySym key;
+            char key_char;
+            if (XLookupString(&xev.xkey, &key_char, 1, &key, 0))
+            {
+                loginfo("keypress: %c", key_char);
+                // dump the trace recorded so far without stopping
+                if (key_char == 't')
+                    trace_write();
+            }
+            events |= X11_EVENT_REDRAW;
+        }
+        break;
+        case Expose:
+        case ConfigureNotify:
+        {
+            events |= X11_EVENT_REDRAW;
+        }
+        break;
+        case ClientMessage:
+        {
+            if (xev.xclient.data.l[0] == ctx->s_wm_delete_message)
+            {
+                events |= X11_EVENT_CLOSE;
+            }
+        }
+        break;
+        case DestroyNotify:
+        {
+            events |= X11_EVENT_CLOSE;
+        }
+        break;
+        }
+    }
+
+    return events;
+}
+
+int x11_window_fd(struct x11_context *ctx)
+{
+    return ConnectionNumber(ctx->display);
+}
+
+void x11_window_destroy(struct x11_context *ctx)
+{
+    if (!ctx || !ctx->display)
+        return;
+
+    XDestroyWindow(ctx->display, ctx->win);
+    XCloseDisplay(ctx->display);
+    ctx->display = NULL;
+}
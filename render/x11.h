@@ -0,0 +1,37 @@
+#ifndef X11_H__
+#define X11_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+    struct x11_context
+    {
+        Display *display;
+        Atom s_wm_delete_message;
+        Window win;
+    };
+
+// x11_window_poll results
+#define X11_EVENT_CLOSE 0x1  // the window was asked to close
+#define X11_EVENT_REDRAW 0x2 // exposed, resized or a key was pressed, the frame should be drawn again
+
+    int x11_window_create(struct x11_context *ctx, int width, int height, const char *title);
+
+    // drain pending events, return a mask of X11_EVENT_*
+    int x11_window_poll(struct x11_context *ctx);
+
+    // the connection, to sleep in poll until the server sends something; x11_window_poll
+    // drains it and flushes pending requests, so call it before sleeping
+    int x11_window_fd(struct x11_context *ctx);
+
+    void x11_window_destroy(struct x11_context *ctx);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // X11_H__
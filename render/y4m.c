@@ -0,0 +1,103 @@
+#include <stdlib.h>
+#include <string.h>
+#include "y4m.h"
+#include "frame_layout.h"
+#include "log.h"
+
+#define Y4M_LINE_MAX 1024
+
+// Y4M colorspace tag -> format module
+static const char *colorspaces_[][2] = {
+    {"444", "i444"},
+    {"420", "i420"},
+    {"420jpeg", "i420"},
+    {"420mpeg2", "i420"},
+    {"420paldv", "i420"},
+    {"420p10", "yuv420p10"},
+};
+
+int y4m_read_header(FILE *fp, struct y4m_header *hdr)
+{
+    char line[Y4M_LINE_MAX];
+    if (!fgets(line, sizeof(line), fp) || strncmp(line, Y4M_MAGIC, strlen(Y4M_MAGIC)) != 0)
+    {
+        logerror("not a YUV4MPEG2 stream");
+        return -1;
+    }
+
+    size_t len = strlen(line);
+    if (line[len - 1] != '\n')
+    {
+        logerror("y4m header longer than %d bytes", Y4M_LINE_MAX);
+        return -1;
+    }
+    line[len - 1] = '\0';
+
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->header_size = len;
+    // the spec default when no C tag is given
+    strcpy(hdr->colorspace, "420jpeg");
+
+    char *save = NULL;
+    for (char *tag = strtok_r(line + strlen(Y4M_MAGIC), " ", &save); tag; tag = strtok_r(NULL, " ", &save))
+    {
+        switch (tag[0])
+        {
+        case 'W': hdr->width = atoi(tag + 1); break;
+        case 'H': hdr->height = atoi(tag + 1); break;
+        case 'F': sscanf(tag + 1, "%d:%d", &hdr->fps_num, &hdr->fps_den); break;
+        case 'C':
+            strncpy(hdr->colorspace, tag + 1, sizeof(hdr->colorspace) - 1);
+            hdr->colorspace[sizeof(hdr->colorspace) - 1] = '\0';
+            break;
+        default: break; // I (interlacing), A (aspect), X (extensions) do not affect upload
+        }
+    }
+
+    if (hdr->width <= 0 || hdr->height <= 0)
+    {
+        logerror("y4m header without valid W/H");
+        return -1;
+    }
+
+    return 0;
+}
+
+int y4m_skip_frame_header(FILE *fp)
+{
+    char line[Y4M_LINE_MAX];
+    if (!fgets(line, sizeof(line), fp))
+        return 1;
+    if (strncmp(line, Y4M_FRAME_MAGIC, strlen(Y4M_FRAME_MAGIC)) != 0 || line[strlen(line) - 1] != '\n')
+    {
+        logerror("bad y4m frame marker");
+        return -1;
+    }
+    return 0;
+}
+
+const char *y4m_format_name(const struct y4m_header *hdr)
+{
+    for (size_t i = 0; i < sizeof(colorspaces_) / sizeof(colorspaces_[0]); ++i)
+    {
+        if (strcmp(colorspaces_[i][0], hdr->colorspace) == 0)
+            return colorspaces_[i][1];
+    }
+
+    // not a standard tag, but allow naming one of our modules directly (Cnv24, Crgb24)
+    if (frame_layout_find(hdr->colorspace))
+        return hdr->colorspace;
+
+    return NULL;
+}
+
+int y4m_probe(const char *filename)
+{
+    char magic[sizeof(Y4M_MAGIC)] = {0};
+    FILE *fp = fopen(filename, "rb");
+    if (!fp)
+        return 0;
+    size_t n = fread(magic, 1, strlen(Y4M_MAGIC), fp);
+    fclose(fp);
+    return n == strlen(Y4M_MAGIC) && memcmp(magic, Y4M_MAGIC, n) == 0;
+}
@@ -0,0 +1,39 @@
+#ifndef Y4M_H__
+#define Y4M_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#include <stdio.h>
+
+#define Y4M_MAGIC "YUV4MPEG2 "
+#define Y4M_FRAME_MAGIC "FRAME"
+
+    struct y4m_header
+    {
+        int width;
+        int height;
+        int fps_num;
+        int fps_den;
+        char colorspace[32];
+        size_t header_size; // bytes up to and including the '\n' of the stream header
+    };
+
+    // parse the stream header at the current position of fp, leaves fp at the first FRAME marker
+    int y4m_read_header(FILE *fp, struct y4m_header *hdr);
+
+    // skip a "FRAME[ params]\n" marker, return 0 on success, 1 at end of file, -1 on garbage
+    int y4m_skip_frame_header(FILE *fp);
+
+    // format module name for the C tag of the header, NULL if none matches
+    const char *y4m_format_name(const struct y4m_header *hdr);
+
+    // true if the file starts with the Y4M magic
+    int y4m_probe(const char *filename);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // Y4M_H__
@@ -0,0 +1,81 @@
+#include <stddef.h>
+#include "yuv420p10.h"
+#include "hdr.h"
+#include "log.h"
+
+static char vertex_shader_src[] =
+    "#version 320 es                          \n"
+    "layout (location = 0) in vec3 aPos;      \n"
+    "layout (location = 1) in vec2 aTexCoord; \n"
+    "out vec2 TexCoord;                       \n"
+    "void main()                              \n"
+    "{                                        \n"
+    "    gl_Position = vec4(aPos, 1.0);       \n"
+    "    TexCoord = aTexCoord;                \n"
+    "}                                        \n";
+static char fragment_shader_src[] =
+    "#version 320 es                                                    \n"
+    "precision highp float;                                             \n" // PQ needs more than mediump
+    HDR_GLSL
+    "out vec4 FragColor;                                                \n"
+    "in vec2 TexCoord;                                                  \n"
+    "uniform highp usampler2D y_texture;                                \n"
+    "uniform highp usampler2D u_texture;                                \n"
+    "uniform highp usampler2D v_texture;                                \n"
+    "void main()                                                        \n"
+    "{                                                                  \n"
+    "    vec3 yuv;                                                      \n"
+    "    yuv.x = texture_bilinear(y_texture, TexCoord).r;               \n"
+    "    yuv.y = texture_bilinear(u_texture, TexCoord).r;               \n"
+    "    yuv.z = texture_bilinear(v_texture, TexCoord).r;               \n"
+    "    vec3 rgb = yuv2020_to_rgb(yuv / 1023.0);                       \n"
+    "    FragColor = vec4(hdr_to_sdr(rgb), 1.0);                        \n"
+    "}                                                                  \n";
+
+void yuv420p10_init(struct format_state *st, int width, int height)
+{
+    st->width = width;
+    st->height = height;
+    st->chroma_width = (width + 1) / 2;
+    st->chroma_height = (height + 1) / 2;
+    st->u_offset = (size_t)width * height * 2;
+    st->v_offset = st->u_offset + (size_t)st->chroma_width * st->chroma_height * 2;
+}
+
+int yuv420p10_init_shader(struct format_state *st)
+{
+    st->program = create_program(vertex_shader_src, fragment_shader_src);
+    if (st->program == 0)
+    {
+        logerror("create_program failed");
+        return -1;
+    }
+
+    glstate_use_program(st->program);
+
+    glUniform1i(glGetUniformLocation(st->program, "y_texture"), 0); // 0 for GL_TEXTURE0
+    glUniform1i(glGetUniformLocation(st->program, "u_texture"), 1);
+    glUniform1i(glGetUniformLocation(st->program, "v_texture"), 2);
+    glUniform1i(glGetUniformLocation(st->program, "transfer"), st->transfer);
+
+    glClearColor(1.0f, 1.0f, 1.0f, 0.0f);
+
+    return 0;
+}
+
+void yuv420p10_init_texture(struct format_state *st, void *buffer)
+{
+    st->texture_count = 3;
+    glGenTextures(st->texture_count, st->textures);
+
+    load_texture_typed(st->upload, GL_TEXTURE0, st->textures[0], GL_R16UI, GL_RED_INTEGER, GL_UNSIGNED_SHORT, st->width, st->height, buffer);
+    load_texture_typed(st->upload, GL_TEXTURE1, st->textures[1], GL_R16UI, GL_RED_INTEGER, GL_UNSIGNED_SHORT, st->chroma_width, st->chroma_height, buffer + st->u_offset);
+    load_texture_typed(st->upload, GL_TEXTURE2, st->textures[2], GL_R16UI, GL_RED_INTEGER, GL_UNSIGNED_SHORT, st->chroma_width, st->chroma_height, buffer + st->v_offset);
+}
+
+void yuv420p10_update_texture(struct format_state *st, void *buffer)
+{
+    update_texture_typed(st->upload, GL_TEXTURE0, st->textures[0], GL_RED_INTEGER, GL_UNSIGNED_SHORT, st->width, st->height, buffer);
+    update_texture_typed(st->upload, GL_TEXTURE1, st->textures[1], GL_RED_INTEGER, GL_UNSIGNED_SHORT, st->chroma_width, st->chroma_height, buffer + st->u_offset);
+    update_texture_typed(st->upload, GL_TEXTURE2, st->textures[2], GL_RED_INTEGER, GL_UNSIGNED_SHORT, st->chroma_width, st->chroma_height, buffer + st->v_offset);
+}
@@ -0,0 +1,20 @@
+#ifndef YUV420P10_H__
+#define YUV420P10_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#include "format.h"
+
+    // yuv420p10le: planar Y, U, V (U/V at half size), 10 bits LSB aligned in 16-bit little endian words
+    void yuv420p10_init(struct format_state *st, int width, int height);
+    int yuv420p10_init_shader(struct format_state *st);
+    void yuv420p10_init_texture(struct format_state *st, void *buffer);
+    void yuv420p10_update_texture(struct format_state *st, void *buffer);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // YUV420P10_H__
@@ -0,0 +1,91 @@
+#include "yuyv.h"
+#include "log.h"
+
+static char vertex_shader_src[] =
+    "#version 320 es                          \n"
+    "layout (location = 0) in vec3 aPos;      \n"
+    "layout (location = 1) in vec2 aTexCoord; \n"
+    "out vec2 TexCoord;                       \n"
+    "void main()                              \n"
+    "{                                        \n"
+    "    gl_Position = vec4(aPos, 1.0);       \n"
+    "    TexCoord = aTexCoord;                \n"
+    "}                                        \n";
+// one RGBA texel holds a Y0 U Y1 V macropixel, the luma sample is picked by the parity of x
+static char fragment_shader_src[] =
+    "#version 320 es                                                    \n"
+    "precision mediump float;                                           \n" // OpenGL ES need explicit precision
+    "out vec4 FragColor;                                                \n"
+    "in vec2 TexCoord;                                                  \n"
+    "uniform sampler2D yuyv_texture;                                    \n"
+    "uniform ivec2 size;                                                \n" // luma width, height
+    "void main()                                                        \n"
+    "{                                                                  \n"
+    "    ivec2 pos = min(ivec2(TexCoord * vec2(size)), size - 1);       \n"
+    "    vec4 texel = texelFetch(yuyv_texture, ivec2(pos.x / 2, pos.y), 0); \n"
+    "    vec3 yuv;                                                      \n"
+    "    yuv.x = (pos.x & 1) == 0 ? texel.r : texel.b;                  \n"
+    "    yuv.yz = texel.ga - vec2(0.5, 0.5);                            \n"
+    "    vec3 rgb = mat3(1,       1,        1,                          \n"
+    "                    0,       -0.39465, 2.03211,                    \n"
+    "                    1.13983, -0.58060, 0.0     ) * yuv;            \n"
+    "    FragColor = vec4(rgb, 1.0);                                    \n"
+    "}                                                                  \n";
+
+void yuyv_init(struct format_state *st, int width, int height)
+{
+    st->width = width;
+    st->height = height;
+    st->chroma_width = (width + 1) / 2;
+    st->swap = 0;
+}
+
+void uyvy_init(struct format_state *st, int width, int height)
+{
+    yuyv_init(st, width, height);
+    st->swap = 1;
+}
+
+int yuyv_init_shader(struct format_state *st)
+{
+    st->program = create_program(vertex_shader_src, fragment_shader_src);
+    if (st->program == 0)
+    {
+        logerror("create_program failed");
+        return -1;
+    }
+
+    glstate_use_program(st->program);
+
+    glUniform1i(glGetUniformLocation(st->program, "yuyv_texture"), 0); // 0 for GL_TEXTURE0
+    glUniform2i(glGetUniformLocation(st->program, "size"), st->width, st->height);
+
+    glClearColor(1.0f, 1.0f, 1.0f, 0.0f);
+
+    return 0;
+}
+
+void yuyv_init_texture(struct format_state *st, void *buffer)
+{
+    st->texture_count = 1;
+    glGenTextures(st->texture_count, st->textures);
+
+    // half width RGBA8, the packed buffer is uploaded as is
+    load_texture(st->upload, GL_TEXTURE0, st->textures[0], GL_RGBA, st->chroma_width, st->height, buffer);
+
+    if (st->swap)
+    {
+        // reorder U Y0 V Y1 to Y0 U Y1 V in the sampler so the shader is shared
+        glstate_bind_texture(GL_TEXTURE_2D, st->textures[0]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_R, GL_GREEN);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, GL_RED);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_ALPHA);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_A, GL_BLUE);
+        glstate_bind_texture(GL_TEXTURE_2D, GL_NONE);
+    }
+}
+
+void yuyv_update_texture(struct format_state *st, void *buffer)
+{
+    update_texture(st->upload, GL_TEXTURE0, st->textures[0], GL_RGBA, st->chroma_width, st->height, buffer);
+}
@@ -0,0 +1,22 @@
+#ifndef YUYV_H__
+#define YUYV_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+#include "format.h"
+
+    // YUYV: packed 4:2:2, Y0 U Y1 V per pair of pixels
+    void yuyv_init(struct format_state *st, int width, int height);
+    // UYVY: packed 4:2:2, U Y0 V Y1 per pair of pixels, shares the other entry points
+    void uyvy_init(struct format_state *st, int width, int height);
+    int yuyv_init_shader(struct format_state *st);
+    void yuyv_init_texture(struct format_state *st, void *buffer);
+    void yuyv_update_texture(struct format_state *st, void *buffer);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+#endif // YUYV_H__
@@ -0,0 +1,650 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <GLES3/gl3.h>
+#include "log.h"
+#include "egl.h"
+#include "util.h"
+#include "format.h"
+#include "renderer.h"
+#include "frame_timing.h"
+#include "cpu_convert.h"
+#include "tilehash.h"
+
+#define DEFAULT_RESOLUTIONS "720p,1080p,4k,8k"
+#define DEFAULT_UPLOADS "direct,pbo,tiles"
+#define DEFAULT_ALIGNMENTS "1,4"
+#define DEFAULT_THREADS "1,0"
+#define DEFAULT_FRAMES 60
+#define DEFAULT_WARMUP 5
+// distinct synthetic frames cycled through, so every upload carries new data
+#define BENCH_FRAMES 2
+#define BENCH_TILE_SIZE 64
+#define BENCH_PBO_COUNT 3
+#define MAX_LIST 32
+
+enum bench_upload
+{
+    BENCH_DIRECT,
+    BENCH_PBO,
+    BENCH_TILES,
+};
+
+static const char *upload_names[] = {"direct", "pbo", "tiles"};
+
+struct resolution
+{
+    const char *name;
+    int width;
+    int height;
+};
+
+static const struct resolution resolutions_[] = {
+    {"720p", 1280, 720},
+    {"1080p", 1920, 1080},
+    {"1440p", 2560, 1440},
+    {"4k", 3840, 2160},
+    {"8k", 7680, 4320},
+};
+
+struct bench_result
+{
+    size_t frames;
+    double seconds;
+    double fps;
+    double upload_gbps;
+    double p50_ms;
+    double p90_ms;
+    double p99_ms;
+    double max_ms;
+};
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "headless upload + draw throughput on synthetic frames, one result row per configuration\n"
+        "  -f <list>   pixel formats: %s (default: all)\n"
+        "  -r <list>   resolutions: 720p, 1080p, 1440p, 4k, 8k or WxH (default: " DEFAULT_RESOLUTIONS ")\n"
+        "  -u <list>   upload strategies: direct, pbo, tiles, whose hash kernels are first checked against\n"
+        "              scalar (default: " DEFAULT_UPLOADS ")\n"
+        "  -a <list>   GL_UNPACK_ALIGNMENT values: 1, 2, 4, 8, skipped where a plane's rows miss them\n"
+        "              (default: " DEFAULT_ALIGNMENTS ")\n"
+        "  -n <count>  measured frames per configuration (default: %d)\n"
+        "  -w <count>  warm-up frames per configuration (default: %d)\n"
+        "  -o <fmt>    output: csv (default) or json\n"
+        "  -c <list>   instead of GL: CPU nv24 to rgb24 kernels scalar, sse4.1, avx2, neon or all,\n"
+        "              each checked bit-exact against scalar\n"
+        "  -t <list>   CPU converter threads, 0 for one per core (default: " DEFAULT_THREADS ")\n",
+        prog, format_names(), DEFAULT_FRAMES, DEFAULT_WARMUP);
+}
+
+// split a comma separated list in place
+static int split_list(char *list, char **items, int max_items)
+{
+    int count = 0;
+    for (char *tok = strtok(list, ","); tok && count < max_items; tok = strtok(NULL, ","))
+        items[count++] = tok;
+    return count;
+}
+
+static int parse_resolution(const char *name, struct resolution *res)
+{
+    for (size_t i = 0; i < sizeof(resolutions_) / sizeof(resolutions_[0]); ++i)
+    {
+        if (strcmp(resolutions_[i].name, name) == 0)
+        {
+            *res = resolutions_[i];
+            return 0;
+        }
+    }
+    res->name = name;
+    if (sscanf(name, "%dx%d", &res->width, &res->height) == 2 && res->width > 0 && res->height > 0)
+        return 0;
+    return -1;
+}
+
+// deterministic content that differs between frames and is not trivially compressible
+static void fill_frame(unsigned char *buffer, size_t size, int seed)
+{
+    unsigned int x = 0x9e3779b9u * (seed + 1);
+    for (size_t i = 0; i < size; ++i)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        buffer[i] = x;
+    }
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static double percentile_ms(const uint64_t *sorted, size_t count, double p)
+{
+    size_t idx = (size_t)(p * (count - 1) + 0.5);
+    return sorted[idx] / 1e6;
+}
+
+// one configuration on a fresh context, so no texture or PBO state leaks between runs;
+// 1 if the tightly packed rows of a plane miss <alignment> and the configuration is skipped
+static int run_config(const struct pixel_format *fmt, const struct resolution *res, enum bench_upload upload,
+    int alignment, unsigned char **frames, int frame_count, int warmup, struct bench_result *result)
+{
+    struct egl_context egl_ctx = {0};
+    if (egl_headless_create(&egl_ctx, res->width, res->height) != 0)
+    {
+        logerror("egl_headless_create failed");
+        return -1;
+    }
+    glstate_invalidate();
+
+    int ret = -1;
+    struct renderer *renderer = NULL;
+    uint64_t *frame_ns = calloc(frame_count, sizeof(*frame_ns));
+    if (!frame_ns)
+    {
+        logerror("calloc failed");
+        goto out;
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    renderer = renderer_create(fmt, res->width, res->height, HDR_TRANSFER_PQ, frames[0]);
+    if (!renderer)
+    {
+        logerror("renderer_create failed");
+        goto out;
+    }
+    if (alignment > upload_row_alignment(renderer_upload_state(renderer)))
+    {
+        logwarn("skip %s %dx%d align %d: plane rows are only %d-byte aligned", fmt->name, res->width, res->height,
+            alignment, upload_row_alignment(renderer_upload_state(renderer)));
+        ret = 1;
+        goto out;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+    set_upload_mode(renderer_upload_state(renderer), upload == BENCH_PBO ? UPLOAD_PBO : UPLOAD_DIRECT, BENCH_PBO_COUNT);
+    set_dirty_tiles(renderer_upload_state(renderer), upload == BENCH_TILES ? BENCH_TILE_SIZE : 0);
+
+    uint64_t begin_ns = 0;
+    for (int i = -warmup; i < frame_count; ++i)
+    {
+        if (i == 0)
+        {
+            glFinish();
+            begin_ns = timing_now_ns();
+        }
+        uint64_t t0 = timing_now_ns();
+
+        // i + warmup keeps the first upload different from the initial texture
+        renderer_update(renderer, frames[(i + warmup + 1) % BENCH_FRAMES]);
+        glClear(GL_COLOR_BUFFER_BIT);
+        renderer_draw(renderer);
+        egl_swap(&egl_ctx);
+
+        if (i >= 0)
+            frame_ns[i] = timing_now_ns() - t0;
+    }
+    glFinish();
+    uint64_t total_ns = timing_now_ns() - begin_ns;
+
+    qsort(frame_ns, frame_count, sizeof(*frame_ns), compare_u64);
+    result->frames = frame_count;
+    result->seconds = total_ns / 1e9;
+    result->fps = frame_count / result->seconds;
+    result->upload_gbps = (double)fmt->frame_size(res->width, res->height) * frame_count / total_ns;
+    result->p50_ms = percentile_ms(frame_ns, frame_count, 0.5);
+    result->p90_ms = percentile_ms(frame_ns, frame_count, 0.9);
+    result->p99_ms = percentile_ms(frame_ns, frame_count, 0.99);
+    result->max_ms = frame_ns[frame_count - 1] / 1e6;
+    ret = 0;
+
+out:
+    free(frame_ns);
+    renderer_destroy(renderer);
+    egl_destroy(&egl_ctx);
+    return ret;
+}
+
+// the CPU converter on the same synthetic frames, no GL involved; <exact> is set
+// when every converted frame matches the single threaded scalar reference
+static int run_cpu_config(const struct resolution *res, enum cpu_isa isa, int threads,
+    unsigned char **frames, int frame_count, int warmup, struct bench_result *result, int *exact)
+{
+    size_t rgb_size = (size_t)res->width * res->height * 3;
+    struct cpu_converter *conv = cpu_converter_create(res->width, res->height, isa, threads);
+    struct cpu_converter *ref = cpu_converter_create(res->width, res->height, CPU_ISA_SCALAR, 1);
+    uint64_t *frame_ns = calloc(frame_count, sizeof(*frame_ns));
+    unsigned char *rgb = malloc(rgb_size);
+    unsigned char *expected = malloc(rgb_size * BENCH_FRAMES);
+    int ret = -1;
+    if (!conv || !ref || !frame_ns || !rgb || !expected)
+    {
+        logerror("cpu converter setup failed");
+        goto out;
+    }
+
+    for (int i = 0; i < BENCH_FRAMES; ++i)
+        cpu_convert_nv24(ref, frames[i], expected + rgb_size * i);
+
+    *exact = 1;
+    for (int i = -warmup; i < frame_count; ++i)
+    {
+        uint64_t t0 = timing_now_ns();
+        int index = (i + warmup) % BENCH_FRAMES;
+        cpu_convert_nv24(conv, frames[index], rgb);
+        if (i >= 0)
+            frame_ns[i] = timing_now_ns() - t0;
+        // outside the timed span, so the total is the sum of the conversions
+        if (*exact && memcmp(rgb, expected + rgb_size * index, rgb_size) != 0)
+            *exact = 0;
+    }
+    uint64_t total_ns = 0;
+    for (int i = 0; i < frame_count; ++i)
+        total_ns += frame_ns[i];
+
+    qsort(frame_ns, frame_count, sizeof(*frame_ns), compare_u64);
+    result->frames = frame_count;
+    result->seconds = total_ns / 1e9;
+    result->fps = frame_count / result->seconds;
+    result->upload_gbps = (double)rgb_size * frame_count / total_ns;
+    result->p50_ms = percentile_ms(frame_ns, frame_count, 0.5);
+    result->p90_ms = percentile_ms(frame_ns, frame_count, 0.9);
+    result->p99_ms = percentile_ms(frame_ns, frame_count, 0.99);
+    result->max_ms = frame_ns[frame_count - 1] / 1e6;
+    ret = 0;
+
+out:
+    free(expected);
+    free(rgb);
+    free(frame_ns);
+    cpu_converter_destroy(ref);
+    cpu_converter_destroy(conv);
+    return ret;
+}
+
+// every tile hash kernel the CPU runs against the scalar reference, on tiles with and
+// without a tail and stride padding, plus the position check the dirty tile skip relies on:
+// the same blocks in another order must hash differently; 0 if all of it holds
+static int check_tile_hash()
+{
+    enum { STRIDE = 512, ROWS = 64 };
+    unsigned char *tile = malloc(STRIDE * ROWS);
+    if (!tile)
+    {
+        logerror("malloc failed");
+        return -1;
+    }
+    fill_frame(tile, STRIDE * ROWS, 0);
+
+    int ret = 0;
+    const char *name;
+    tile_hash_func func;
+    // odd start and widths, so loads are unaligned and rows end in a tail
+    static const size_t row_bytes[] = {1, 31, 32, 33, 96, 192, 255, 256, STRIDE - 3};
+    for (int k = 0; (func = tile_hash_kernel_at(k, &name)) != NULL; ++k)
+    {
+        for (size_t i = 0; i < sizeof(row_bytes) / sizeof(row_bytes[0]); ++i)
+        {
+            for (int rows = 1; rows <= ROWS; rows *= 4)
+            {
+                if (func(tile + 3, row_bytes[i], rows, STRIDE) != tile_hash_reference(tile + 3, row_bytes[i], rows, STRIDE))
+                {
+                    logerror("tile hash kernel %s differs from scalar at %zu bytes x %d rows", name, row_bytes[i], rows);
+                    ret = -1;
+                }
+            }
+        }
+    }
+
+    // swap two blocks within a row, then two blocks of different rows
+    uint64_t hash = tile_hash(tile, 256, ROWS, STRIDE);
+    unsigned char block[32];
+    memcpy(block, tile, 32);
+    memcpy(tile, tile + 64, 32);
+    memcpy(tile + 64, block, 32);
+    uint64_t swapped = tile_hash(tile, 256, ROWS, STRIDE);
+    memcpy(tile + 64, tile + STRIDE + 64, 32);
+    memcpy(tile + STRIDE + 64, block, 32);
+    if (swapped == hash || tile_hash(tile, 256, ROWS, STRIDE) == swapped)
+    {
+        logerror("tile hash %s ignores where blocks sit in the tile", tile_hash_kernel());
+        ret = -1;
+    }
+
+    free(tile);
+    return ret;
+}
+
+static void print_result(int json, int *first, const struct pixel_format *fmt, const struct resolution *res,
+    enum bench_upload upload, int alignment, const struct bench_result *r)
+{
+    if (json)
+    {
+        printf("%s\n  {\"format\": \"%s\", \"width\": %d, \"height\": %d, \"upload\": \"%s\", \"alignment\": %d, "
+               "\"frames\": %zu, \"seconds\": %.3f, \"fps\": %.2f, \"upload_gbps\": %.3f, "
+               "\"p50_ms\": %.3f, \"p90_ms\": %.3f, \"p99_ms\": %.3f, \"max_ms\": %.3f}",
+            *first ? "" : ",", fmt->name, res->width, res->height, upload_names[upload], alignment,
+            r->frames, r->seconds, r->fps, r->upload_gbps, r->p50_ms, r->p90_ms, r->p99_ms, r->max_ms);
+    }
+    else
+    {
+        if (*first)
+            printf("format,width,height,upload,alignment,frames,seconds,fps,upload_gbps,p50_ms,p90_ms,p99_ms,max_ms\n");
+        printf("%s,%d,%d,%s,%d,%zu,%.3f,%.2f,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+            fmt->name, res->width, res->height, upload_names[upload], alignment,
+            r->frames, r->seconds, r->fps, r->upload_gbps, r->p50_ms, r->p90_ms, r->p99_ms, r->max_ms);
+    }
+    *first = 0;
+    fflush(stdout);
+}
+
+static void print_cpu_result(int json, int *first, const struct resolution *res, enum cpu_isa isa, int threads,
+    int exact, const struct bench_result *r)
+{
+    if (json)
+    {
+        printf("%s\n  {\"format\": \"nv24\", \"width\": %d, \"height\": %d, \"kernel\": \"%s\", \"threads\": %d, "
+               "\"frames\": %zu, \"seconds\": %.3f, \"fps\": %.2f, \"output_gbps\": %.3f, "
+               "\"p50_ms\": %.3f, \"p90_ms\": %.3f, \"p99_ms\": %.3f, \"max_ms\": %.3f, \"exact\": %s}",
+            *first ? "" : ",", res->width, res->height, cpu_isa_name(isa), threads,
+            r->frames, r->seconds, r->fps, r->upload_gbps, r->p50_ms, r->p90_ms, r->p99_ms, r->max_ms,
+            exact ? "true" : "false");
+    }
+    else
+    {
+        if (*first)
+            printf("format,width,height,kernel,threads,frames,seconds,fps,output_gbps,p50_ms,p90_ms,p99_ms,max_ms,exact\n");
+        printf("nv24,%d,%d,%s,%d,%zu,%.3f,%.2f,%.3f,%.3f,%.3f,%.3f,%.3f,%d\n",
+            res->width, res->height, cpu_isa_name(isa), threads,
+            r->frames, r->seconds, r->fps, r->upload_gbps, r->p50_ms, r->p90_ms, r->p99_ms, r->max_ms, exact);
+    }
+    *first = 0;
+    fflush(stdout);
+}
+
+// -c mode: every resolution x kernel x thread count
+static int run_cpu(int json, struct resolution *res, int res_count, enum cpu_isa *isas, int isa_count,
+    int *threads, int thread_count, int frame_count, int warmup)
+{
+    int first = 1;
+    int failures = 0;
+    if (json)
+        printf("[");
+
+    for (int r = 0; r < res_count; ++r)
+    {
+        size_t size = (size_t)res[r].width * res[r].height * 3;
+        unsigned char *frames[BENCH_FRAMES] = {0};
+        int ok = 1;
+        for (int i = 0; i < BENCH_FRAMES; ++i)
+        {
+            frames[i] = malloc(size);
+            if (!frames[i])
+            {
+                logerror("malloc %zu failed, skip %dx%d", size, res[r].width, res[r].height);
+                ok = 0;
+                break;
+            }
+            fill_frame(frames[i], size, i);
+        }
+
+        for (int k = 0; ok && k < isa_count; ++k)
+        {
+            for (int t = 0; t < thread_count; ++t)
+            {
+                struct bench_result result;
+                int exact;
+                if (run_cpu_config(&res[r], isas[k], threads[t], frames, frame_count, warmup, &result, &exact) != 0)
+                {
+                    logerror("cpu %dx%d %s %d threads failed", res[r].width, res[r].height, cpu_isa_name(isas[k]), threads[t]);
+                    ++failures;
+                    continue;
+                }
+                if (!exact)
+                {
+                    logerror("cpu %dx%d %s differs from scalar", res[r].width, res[r].height, cpu_isa_name(isas[k]));
+                    ++failures;
+                }
+                print_cpu_result(json, &first, &res[r], isas[k], threads[t], exact, &result);
+            }
+        }
+
+        for (int i = 0; i < BENCH_FRAMES; ++i)
+            free(frames[i]);
+    }
+
+    if (json)
+        printf("\n]\n");
+
+    return failures > 0 ? -1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // results go to stdout, keep stderr for problems
+    set_log_level(LOG_LEVEL_WARN);
+
+    char *format_list = NULL;
+    char resolution_list[256] = DEFAULT_RESOLUTIONS;
+    char upload_list[64] = DEFAULT_UPLOADS;
+    char alignment_list[64] = DEFAULT_ALIGNMENTS;
+    int frame_count = DEFAULT_FRAMES;
+    int warmup = DEFAULT_WARMUP;
+    int json = 0;
+    char *cpu_list = NULL;
+    char thread_list[64] = DEFAULT_THREADS;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "f:r:u:a:n:w:o:c:t:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'f': format_list = optarg; break;
+        case 'r': snprintf(resolution_list, sizeof(resolution_list), "%s", optarg); break;
+        case 'u': snprintf(upload_list, sizeof(upload_list), "%s", optarg); break;
+        case 'a': snprintf(alignment_list, sizeof(alignment_list), "%s", optarg); break;
+        case 'n': frame_count = atoi(optarg); break;
+        case 'w': warmup = atoi(optarg); break;
+        case 'c': cpu_list = optarg; break;
+        case 't': snprintf(thread_list, sizeof(thread_list), "%s", optarg); break;
+        case 'o':
+            if (strcmp(optarg, "json") == 0)
+                json = 1;
+            else if (strcmp(optarg, "csv") != 0)
+            {
+                logerror("unknown output %s", optarg);
+                usage(argv[0]);
+                return -1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return -1;
+        }
+    }
+    if (frame_count < 1 || warmup < 0)
+    {
+        logerror("invalid frame count %d or warm-up %d", frame_count, warmup);
+        return -1;
+    }
+
+    // resolve every list up front so a typo fails before hours of benchmarking
+    const struct pixel_format *formats[MAX_LIST];
+    int format_count = 0;
+    if (format_list && strcmp(format_list, "all") != 0)
+    {
+        char *names[MAX_LIST];
+        int count = split_list(format_list, names, MAX_LIST);
+        for (int i = 0; i < count; ++i)
+        {
+            formats[format_count] = format_find(names[i]);
+            if (!formats[format_count++])
+            {
+                logerror("unknown format %s", names[i]);
+                return -1;
+            }
+        }
+    }
+    else
+    {
+        while (format_count < MAX_LIST && format_at(format_count))
+        {
+            formats[format_count] = format_at(format_count);
+            ++format_count;
+        }
+    }
+
+    struct resolution res[MAX_LIST];
+    char *items[MAX_LIST];
+    int res_count = split_list(resolution_list, items, MAX_LIST);
+    for (int i = 0; i < res_count; ++i)
+    {
+        if (parse_resolution(items[i], &res[i]) != 0)
+        {
+            logerror("invalid resolution %s", items[i]);
+            return -1;
+        }
+    }
+
+    if (cpu_list)
+    {
+        enum cpu_isa isas[CPU_ISA_COUNT];
+        int isa_count = 0;
+        if (strcmp(cpu_list, "all") == 0)
+        {
+            for (int i = 0; i < CPU_ISA_COUNT; ++i)
+            {
+                if (cpu_isa_supported(i))
+                    isas[isa_count++] = i;
+            }
+        }
+        else
+        {
+            int count = split_list(cpu_list, items, MAX_LIST);
+            for (int i = 0; i < count && isa_count < CPU_ISA_COUNT; ++i)
+            {
+                enum cpu_isa isa = cpu_isa_find(items[i]);
+                if (isa == CPU_ISA_COUNT || !cpu_isa_supported(isa))
+                {
+                    logerror("cpu kernel %s unknown or not supported here", items[i]);
+                    return -1;
+                }
+                isas[isa_count++] = isa;
+            }
+        }
+
+        int threads[MAX_LIST];
+        int thread_count = split_list(thread_list, items, MAX_LIST);
+        for (int i = 0; i < thread_count; ++i)
+        {
+            threads[i] = atoi(items[i]);
+            if (threads[i] < 0)
+            {
+                logerror("invalid thread count %s", items[i]);
+                return -1;
+            }
+        }
+
+        return run_cpu(json, res, res_count, isas, isa_count, threads, thread_count, frame_count, warmup);
+    }
+
+    enum bench_upload uploads[MAX_LIST];
+    int upload_count = split_list(upload_list, items, MAX_LIST);
+    for (int i = 0; i < upload_count; ++i)
+    {
+        int found = 0;
+        for (int u = 0; u < (int)(sizeof(upload_names) / sizeof(upload_names[0])); ++u)
+        {
+            if (strcmp(items[i], upload_names[u]) == 0)
+            {
+                uploads[i] = u;
+                found = 1;
+            }
+        }
+        if (!found)
+        {
+            logerror("unknown upload strategy %s", items[i]);
+            return -1;
+        }
+    }
+
+    int alignments[MAX_LIST];
+    int alignment_count = split_list(alignment_list, items, MAX_LIST);
+    for (int i = 0; i < alignment_count; ++i)
+    {
+        alignments[i] = atoi(items[i]);
+        if (alignments[i] != 1 && alignments[i] != 2 && alignments[i] != 4 && alignments[i] != 8)
+        {
+            logerror("invalid alignment %s", items[i]);
+            return -1;
+        }
+    }
+
+    int first = 1;
+    int failures = 0;
+    for (int u = 0; u < upload_count; ++u)
+    {
+        // a wrong hash skips changed tiles and would time uploads that never happen
+        if (uploads[u] == BENCH_TILES && check_tile_hash() != 0)
+        {
+            ++failures;
+            break;
+        }
+    }
+    if (json)
+        printf("[");
+
+    for (int f = 0; f < format_count; ++f)
+    {
+        for (int r = 0; r < res_count; ++r)
+        {
+            // synthetic frames are shared by every strategy and alignment of this format and size
+            size_t size = formats[f]->frame_size(res[r].width, res[r].height);
+            unsigned char *frames[BENCH_FRAMES] = {0};
+            int ok = 1;
+            for (int i = 0; i < BENCH_FRAMES; ++i)
+            {
+                frames[i] = malloc(size);
+                if (!frames[i])
+                {
+                    logerror("malloc %zu failed, skip %s %dx%d", size, formats[f]->name, res[r].width, res[r].height);
+                    ok = 0;
+                    break;
+                }
+                fill_frame(frames[i], size, i);
+            }
+
+            for (int u = 0; ok && u < upload_count; ++u)
+            {
+                for (int a = 0; a < alignment_count; ++a)
+                {
+                    struct bench_result result;
+                    int rc = run_config(formats[f], &res[r], uploads[u], alignments[a], frames, frame_count, warmup, &result);
+                    if (rc > 0)
+                        continue;
+                    if (rc != 0)
+                    {
+                        logerror("%s %dx%d %s align %d failed", formats[f]->name, res[r].width, res[r].height,
+                            upload_names[uploads[u]], alignments[a]);
+                        ++failures;
+                        continue;
+                    }
+                    print_result(json, &first, formats[f], &res[r], uploads[u], alignments[a], &result);
+                }
+            }
+
+            for (int i = 0; i < BENCH_FRAMES; ++i)
+                free(frames[i]);
+        }
+    }
+
+    if (json)
+        printf("\n]\n");
+
+    return failures > 0 ? -1 : 0;
+}
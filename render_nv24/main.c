@@ -8,6 +8,10 @@
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
 #include "log.h"
+#include "frame_timing.h"
+#include "program_cache.h"
+#include "shader.h"
+#include "event_loop.h"
 
 static EGLint get_context_render_type(EGLDisplay egl_display)
 {
@@ -17,100 +21,6 @@ static EGLint get_context_render_type(EGLDisplay egl_display)
     return EGL_OPENGL_ES2_BIT;
 }
 
-static int check_error(GLuint x)
-{
-    void (*glGetiv)(GLuint x, GLenum pname, GLint *params);
-    void (*glGetInfoLog)(GLuint x, GLsizei bufSize, GLsizei *length, GLchar *infoLog);
-    void (*glDelete)(GLuint x);
-    GLenum pname_status;
-
-    if (glIsShader(x))
-    {
-        glGetiv = glGetShaderiv;
-        glGetInfoLog = glGetShaderInfoLog;
-        glDelete = glDeleteShader;
-        pname_status = GL_COMPILE_STATUS;
-    }
-    else if (glIsProgram(x))
-    {
-        glGetiv = glGetProgramiv;
-        glGetInfoLog = glGetProgramInfoLog;
-        glDelete = glDeleteProgram;
-        pname_status = GL_LINK_STATUS;
-    }
-    else
-    {
-        logerror("invalid x");
-        return -1;
-    }
-
-    GLint success;
-    glGetiv(x, pname_status, &success);
-    if (!success)
-    {
-        GLint info_len = 0;
-        glGetiv(x, GL_INFO_LOG_LENGTH, &info_len);
-        if (info_len > 1)
-        {
-            char *info_log = calloc(1, info_len);
-            glGetInfoLog(x, info_len, NULL, info_log);
-            logerror("failed: %s", info_log);
-            free(info_log);
-        }
-        glDelete(x);
-        return -1;
-    }
-
-    return 0;
-}
-
-static GLuint load_shader(GLenum type, const char *shader_src)
-{
-    GLuint shader = glCreateShader(type);
-    if (shader == 0)
-    {
-        logerror("glCreateShader failed");
-        return 0;
-    }
-
-    // load the shader source
-    glShaderSource(shader, 1, &shader_src, NULL);
-
-    // compile the shader
-    glCompileShader(shader);
-
-    if (check_error(shader) != 0)
-    {
-        logerror("error accured");
-        return 0;
-    }
-
-    return shader;
-}
-
-static GLuint link_program(GLuint vertex_shader, GLuint fragment_shader)
-{
-    GLuint program = glCreateProgram();
-    if (program == 0)
-    {
-        logerror("glCreateProgram failed");
-        return 0;
-    }
-
-    glAttachShader(program, vertex_shader);
-    glAttachShader(program, fragment_shader);
-
-    glLinkProgram(program);
-
-    if (check_error(program) != 0)
-    {
-        logerror("error occured");
-        return 0;
-    }
-
-    return program;
-}
-
 static void load_texture(GLuint texture, GLint format, GLsizei width, GLsizei height, void *buffer)
 {
     glBindTexture(GL_TEXTURE_2D, texture);
@@ -136,7 +46,7 @@ int main()
         logfatal("XOpenDisplay failed");
 
     Window root = XDefaultRootWindow(x11_display);
-    XSetWindowAttributes swa = {.event_mask = ExposureMask | PointerMotionMask | KeyPressMask};
+    XSetWindowAttributes swa = {.event_mask = ExposureMask | StructureNotifyMask | KeyPressMask};
     Window x11_window = XCreateWindow(
         x11_display, root,
         0, 0, 960, 540, 0,
@@ -313,26 +223,13 @@ int main()
         "    FragColor = vec4(rgb, 1.0);                                    \n"
         "}                                                                  \n";
 
-    GLuint vertex_shader = load_shader(GL_VERTEX_SHADER, vertex_shader_src);
-    if (vertex_shader == 0)
-    {
-        logerror("load_shader VERTEX failed");
-        return -1;
-    }
-
-    GLuint fragment_shader = load_shader(GL_FRAGMENT_SHADER, fragment_shader_src);
-    if (fragment_shader == 0)
-    {
-        logerror("load_shader FRAGMENT failed");
-        return -1;
-    }
-
-    GLuint program = link_program(vertex_shader, fragment_shader);
+    GLuint program = create_program(vertex_shader_src, fragment_shader_src);
     if (program == 0)
     {
-        logerror("link_program failed");
+        logerror("create_program failed");
         return -1;
     }
+    program_cache_report();
 
     glUseProgram(program);
 
@@ -368,11 +265,21 @@ int main()
 
     XEvent xev2;
     int stop = 0;
-    size_t time_ms_ckpt = 0;
-    size_t seq = 0, seq_ckpt = 0;
+    // the image never changes: draw it once, then again only on expose, resize or a key
+    int redraw = 1;
+    struct event_loop *events = event_loop_create();
+    if (!events)
+        logfatal("event_loop_create failed");
+    event_loop_add(events, ConnectionNumber(x11_display));
+    // fps plus per-stage p50/p90/p99/max every second
+    timing_init(0, 1000, NULL);
 
     while (!stop)
     {
+        // sleep until the server sends something, XPending flushes our requests first
+        if (!redraw && !XPending(x11_display))
+            event_loop_wait(events, -1);
+
         // event handle
         while (XPending(x11_display))
         {
@@ -387,6 +294,13 @@ int main()
                 {
                     loginfo("keypress: %c", key_char);
                 }
+                redraw = 1;
+            }
+            break;
+            case Expose:
+            case ConfigureNotify:
+            {
+                redraw = 1;
             }
             break;
             case ClientMessage:
@@ -405,18 +319,10 @@ int main()
             }
         }
 
-        // fps calc
-        struct timespec tp;
-        clock_gettime(CLOCK_MONOTONIC, &tp);
-        size_t time_ms_curr = tp.tv_sec * 1e3 + tp.tv_nsec / 1e6;
-        if (time_ms_curr - time_ms_ckpt > 1000)
-        {
-            loginfo("fps: %d", seq - seq_ckpt);
-            seq_ckpt = seq;
-            time_ms_ckpt = time_ms_curr;
-        }
-
-        ++seq;
+        if (!redraw)
+            continue;
+        redraw = 0;
+        timing_mark(TIMING_EVENTS);
 
         // active GL_TEXTURE0
         glActiveTexture(GL_TEXTURE0);
@@ -425,6 +331,7 @@ int main()
         glActiveTexture(GL_TEXTURE1);
         glBindTexture(GL_TEXTURE_2D, textures[1]);
         glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 1920, 1080, GL_RG, GL_UNSIGNED_BYTE, buffer + 1920 * 1080);
+        timing_mark(TIMING_UPLOAD);
         // clear window
         glClear(GL_COLOR_BUFFER_BIT);
         // use shader program
@@ -436,7 +343,13 @@ int main()
         // unbind
         glBindVertexArray(0);
         glUseProgram(0);
+        timing_mark(TIMING_DRAW);
 
         eglSwapBuffers(egl_display, egl_surface);
+        timing_mark(TIMING_SWAP);
+        timing_frame_end();
     }
+
+    event_loop_destroy(events);
+    timing_destroy();
 }
\ No newline at end of file
@@ -0,0 +1,280 @@
+#define _GNU_SOURCE // memfd_create
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "log.h"
+#include "frame_layout.h"
+#include "y4m.h"
+#include "shm_ring.h"
+
+#define DEFAULT_NAME "/render_frames"
+#define DEFAULT_FORMAT "rgb24"
+#define DEFAULT_SLOTS 4
+#define WAIT_MS 100
+
+static volatile sig_atomic_t stop_ = 0;
+
+// nothing more to do once interrupted or the renderer is gone
+static int stopped(struct shm_ring_header *ring)
+{
+    return stop_ || (atomic_load(&ring->flags) & SHM_RING_DETACHED);
+}
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    stop_ = 1;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+        "usage: %s [options] <file>\n"
+        "publish the frames of a raw or .y4m file into a shared memory ring for render -s shm\n"
+        "  -f <format> raw file pixel format: %s (default: " DEFAULT_FORMAT ")\n"
+        "  -g <WxH>    raw file geometry (default: 1920x1080)\n"
+        "  -r <fps>    publish rate, 0 as fast as the renderer releases slots (default: Y4M rate, else 0)\n"
+        "  -k <slots>  ring slots, %d..%d (default: %d)\n"
+        "  -l          loop at end of file\n"
+        "  -o <name>   POSIX shm name of the ring (default: " DEFAULT_NAME ")\n"
+        "  -m          anonymous memfd instead, its /proc/<pid>/fd/<n> path is printed for render\n",
+        prog, frame_layout_names(), SHM_RING_MIN_SLOTS, SHM_RING_MAX_SLOTS, DEFAULT_SLOTS);
+}
+
+static int64_t now_ns()
+{
+    struct timespec tp;
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return (int64_t)tp.tv_sec * 1000000000 + tp.tv_nsec;
+}
+
+static size_t round_up(size_t size, size_t align)
+{
+    return (size + align - 1) / align * align;
+}
+
+// the next frame of fp into <data>, 0 on success, 1 at end of file
+static int read_frame(FILE *fp, int y4m, void *data, size_t size)
+{
+    if (y4m)
+    {
+        int ret = y4m_skip_frame_header(fp);
+        if (ret != 0)
+            return ret;
+    }
+    return fread(data, 1, size, fp) == size ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+    set_log_level(LOG_LEVEL_INFO);
+
+    const char *format_name = DEFAULT_FORMAT;
+    int width = 1920;
+    int height = 1080;
+    double fps = -1;
+    int slots = DEFAULT_SLOTS;
+    int loop = 0;
+    const char *name = DEFAULT_NAME;
+    int use_memfd = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "f:g:r:k:lo:m")) != -1)
+    {
+        switch (opt)
+        {
+        case 'f': format_name = optarg; break;
+        case 'g':
+            if (sscanf(optarg, "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0)
+            {
+                usage(argv[0]);
+                return -1;
+            }
+            break;
+        case 'r': fps = atof(optarg); break;
+        case 'k': slots = atoi(optarg); break;
+        case 'l': loop = 1; break;
+        case 'o': name = optarg; break;
+        case 'm': use_memfd = 1; break;
+        default:
+            usage(argv[0]);
+            return -1;
+        }
+    }
+    if (optind >= argc || slots < SHM_RING_MIN_SLOTS || slots > SHM_RING_MAX_SLOTS)
+    {
+        usage(argv[0]);
+        return -1;
+    }
+    const char *filename = argv[optind];
+
+    FILE *fp = fopen(filename, "rb");
+    if (!fp)
+    {
+        logerror("fopen %s failed", filename);
+        return -1;
+    }
+    int y4m = 0;
+    long data_start = 0;
+    uint32_t fps_num = 0, fps_den = 0;
+    if (y4m_probe(filename))
+    {
+        struct y4m_header hdr;
+        if (y4m_read_header(fp, &hdr) != 0)
+            return -1;
+        format_name = y4m_format_name(&hdr);
+        if (!format_name)
+        {
+            logerror("unsupported y4m colorspace C%s", hdr.colorspace);
+            return -1;
+        }
+        width = hdr.width;
+        height = hdr.height;
+        if (hdr.fps_den > 0)
+        {
+            fps_num = hdr.fps_num;
+            fps_den = hdr.fps_den;
+        }
+        y4m = 1;
+        data_start = hdr.header_size;
+    }
+    // an explicit rate overrides the file's, in the header as well so timestamps agree
+    if (fps > 0)
+    {
+        fps_num = (uint32_t)(fps * 1000 + 0.5);
+        fps_den = 1000;
+    }
+    else if (fps < 0)
+        fps = fps_den > 0 ? (double)fps_num / fps_den : 0;
+
+    const struct frame_layout *fmt = frame_layout_find(format_name);
+    if (!fmt)
+    {
+        logerror("unknown format %s", format_name);
+        usage(argv[0]);
+        return -1;
+    }
+    size_t frame_size = fmt->frame_size(width, height);
+
+    // slots start on page boundaries so the renderer's uploads read aligned rows
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t data_offset = round_up(sizeof(struct shm_ring_header), page_size);
+    size_t slot_size = round_up(frame_size, page_size);
+    size_t length = data_offset + slot_size * slots;
+
+    int fd;
+    if (use_memfd)
+        fd = memfd_create("render_frames", 0);
+    else
+    {
+        // a ring left behind by a killed producer is replaced
+        shm_unlink(name);
+        fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    }
+    if (fd < 0 || ftruncate(fd, length) != 0)
+    {
+        logerror("create frame ring of %zu bytes failed", length);
+        return -1;
+    }
+    struct shm_ring_header *ring = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ring == MAP_FAILED)
+    {
+        logerror("mmap failed");
+        return -1;
+    }
+
+    // fresh pages are zero, so head, tail and flags already are
+    ring->version = SHM_RING_VERSION;
+    ring->slot_count = slots;
+    ring->slot_size = slot_size;
+    ring->data_offset = data_offset;
+    snprintf(ring->format, sizeof(ring->format), "%s", fmt->name);
+    ring->width = width;
+    ring->height = height;
+    ring->fps_num = fps_num;
+    ring->fps_den = fps_den;
+    __atomic_store_n(&ring->magic, SHM_RING_MAGIC, __ATOMIC_RELEASE);
+
+    if (use_memfd)
+    {
+        // for scripts waiting on it
+        printf("/proc/%d/fd/%d\n", getpid(), fd);
+        fflush(stdout);
+    }
+    loginfo("%s: %s %dx%d, %.3f fps, %d slots of %zu bytes in %s",
+        filename, fmt->name, width, height, fps, slots, slot_size, use_memfd ? "a memfd" : name);
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    fseek(fp, data_start, SEEK_SET);
+
+    uint32_t head = 0;
+    size_t full_waits = 0;
+    int64_t start_ns = now_ns();
+    while (!stopped(ring))
+    {
+        // wait for the renderer to release the oldest slot
+        uint32_t tail = atomic_load(&ring->tail);
+        if (head - tail >= (uint32_t)slots)
+        {
+            ++full_waits;
+            while (!stopped(ring) && head - (tail = atomic_load(&ring->tail)) >= (uint32_t)slots)
+                shm_ring_wait(&ring->tail, &ring->tail_waiting, tail, WAIT_MS);
+            if (stopped(ring))
+                break;
+        }
+
+        uint32_t index = head % slots;
+        int ret = read_frame(fp, y4m, shm_ring_slot_data(ring, index), frame_size);
+        if (ret != 0 && loop && head > 0)
+        {
+            fseek(fp, data_start, SEEK_SET);
+            ret = read_frame(fp, y4m, shm_ring_slot_data(ring, index), frame_size);
+        }
+        if (ret != 0)
+            break;
+
+        struct shm_ring_slot *slot = &ring->slots[index];
+        snprintf(slot->format, sizeof(slot->format), "%s", fmt->name);
+        slot->width = width;
+        slot->height = height;
+        slot->size = frame_size;
+        slot->seq = head;
+        slot->pts_ns = fps_num > 0 ? (int64_t)((double)head * fps_den * 1e9 / fps_num) : -1;
+
+        if (fps > 0)
+        {
+            int64_t due_ns = start_ns + (int64_t)(head * 1e9 / fps);
+            struct timespec due = {due_ns / 1000000000, due_ns % 1000000000};
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL);
+        }
+        slot->publish_ns = now_ns();
+
+        // the slot is complete before head says so
+        atomic_store(&ring->head, ++head);
+        shm_ring_wake(&ring->head, &ring->head_waiting);
+    }
+
+    atomic_fetch_or(&ring->flags, SHM_RING_EOF);
+    shm_ring_wake(&ring->head, &ring->head_waiting);
+    loginfo("published %u frames, ring full %zu times", head, full_waits);
+
+    // a memfd lives as long as someone maps it, but the renderer has to open it through
+    // this process, and a shm name is best unlinked once the renderer is done with it
+    uint32_t tail;
+    while (!stopped(ring) && (tail = atomic_load(&ring->tail)) != head)
+        shm_ring_wait(&ring->tail, &ring->tail_waiting, tail, WAIT_MS);
+
+    if (!use_memfd)
+        shm_unlink(name);
+    munmap(ring, length);
+    close(fd);
+    fclose(fp);
+
+    return 0;
+}
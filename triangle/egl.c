@@ -1,8 +1,10 @@
 #include <string.h>
 #include <stdlib.h>
-#include <time.h>
 #include "egl.h"
 #include "log.h"
+#include "program_cache.h"
+#include "shader.h"
+#include "frame_timing.h"
 
 static EGLint get_context_render_type(EGLDisplay egl_display)
 {
@@ -12,100 +14,6 @@ static EGLint get_context_render_type(EGLDisplay egl_display)
     return EGL_OPENGL_ES2_BIT;
 }
 
-static int check_error(GLuint x)
-{
-    void (*glGetiv)(GLuint x, GLenum pname, GLint *params);
-    void (*glGetInfoLog)(GLuint x, GLsizei bufSize, GLsizei *length, GLchar *infoLog);
-    void (*glDelete)(GLuint x);
-    GLenum pname_status;
-
-    if (glIsShader(x))
-    {
-        glGetiv = glGetShaderiv;
-        glGetInfoLog = glGetShaderInfoLog;
-        glDelete = glDeleteShader;
-        pname_status = GL_COMPILE_STATUS;
-    }
-    else if (glIsProgram(x))
-    {
-        glGetiv = glGetProgramiv;
-        glGetInfoLog = glGetProgramInfoLog;
-        glDelete = glDeleteProgram;
-        pname_status = GL_LINK_STATUS;
-    }
-    else
-    {
-        logerror("invalid x");
-        return -1;
-    }
-
-    GLint success;
-    glGetiv(x, pname_status, &success);
-    if (!success)
-    {
-        GLint info_len = 0;
-        glGetiv(x, GL_INFO_LOG_LENGTH, &info_len);
-        if (info_len > 1)
-        {
-            char *info_log = calloc(1, info_len);
-            glGetInfoLog(x, info_len, NULL, info_log);
-            logerror("failed: %s", info_log);
-            free(info_log);
-        }
-        glDelete(x);
-        return -1;
-    }
-
-    return 0;
-}
-
-static GLuint load_shader(GLenum type, const char *shader_src)
-{
-    GLuint shader = glCreateShader(type);
-    if (shader == 0)
-    {
-        logerror("glCreateShader failed");
-        return 0;
-    }
-
-    // load the shader source
-    glShaderSource(shader, 1, &shader_src, NULL);
-
-    // compile the shader
-    glCompileShader(shader);
-
-    if (check_error(shader) != 0)
-    {
-        logerror("error accured");
-        return 0;
-    }
-
-    return shader;
-}
-
-static GLuint link_program(GLuint vertex_shader, GLuint fragment_shader)
-{
-    GLuint program = glCreateProgram();
-    if (program == 0)
-    {
-        logerror("glCreateProgram failed");
-        return 0;
-    }
-
-    glAttachShader(program, vertex_shader);
-    glAttachShader(program, fragment_shader);
-
-    glLinkProgram(program);
-
-    if (check_error(program) != 0)
-    {
-        logerror("error occured");
-        return 0;
-    }
-
-    return program;
-}
-
 int egl_window_create(struct egl_context *ctx, EGLNativeDisplayType egl_native_display, EGLNativeWindowType egl_native_window)
 {
     if (!ctx)
@@ -179,26 +87,13 @@ int egl_window_create(struct egl_context *ctx, EGLNativeDisplayType egl_native_d
 
 int egl_load_shader(struct egl_context *ctx, const char *vertex_shader_src, const char *fragment_shader_src)
 {
-    GLuint vertex_shader = load_shader(GL_VERTEX_SHADER, vertex_shader_src);
-    if (vertex_shader == 0)
-    {
-        logerror("load_shader VERTEX failed");
-        return -1;
-    }
-
-    GLuint fragment_shader = load_shader(GL_FRAGMENT_SHADER, fragment_shader_src);
-    if (fragment_shader == 0)
-    {
-        logerror("load_shader FRAGMENT failed");
-        return -1;
-    }
-
-    ctx->program = link_program(vertex_shader, fragment_shader);
+    ctx->program = create_program(vertex_shader_src, fragment_shader_src);
     if (ctx->program == 0)
     {
-        logerror("link_program failed");
+        logerror("create_program failed");
         return -1;
     }
+    program_cache_report();
 
     glClearColor(1.0f, 1.0f, 1.0f, 0.0f);
 
@@ -207,17 +102,8 @@ int egl_load_shader(struct egl_context *ctx, const char *vertex_shader_src, cons
 
 void egl_draw(struct egl_context *ctx)
 {
-    struct timespec tp;
-    clock_gettime(CLOCK_MONOTONIC, &tp);
-    size_t time_ms_curr = tp.tv_sec * 1e3 + tp.tv_nsec / 1e6;
-    if (time_ms_curr - ctx->time_ms_ckpt > 1000)
-    {
-        loginfo("fps: %d", ctx->seq - ctx->seq_ckpt);
-        ctx->seq_ckpt = ctx->seq;
-        ctx->time_ms_ckpt = time_ms_curr;
-    }
-
-    ++ctx->seq;
+    // everything since the previous frame is the x11 event pump
+    timing_mark(TIMING_EVENTS);
 
     // draw a triangle
     GLfloat vertices[] = {
@@ -239,6 +125,9 @@ void egl_draw(struct egl_context *ctx)
     glEnableVertexAttribArray(0);
 
     glDrawArrays(GL_TRIANGLES, 0, 3);
+    timing_mark(TIMING_DRAW);
 
     eglSwapBuffers(ctx->display, ctx->surface);
+    timing_mark(TIMING_SWAP);
+    timing_frame_end();
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "x11.h"
 #include "egl.h"
 #include "log.h"
+#include "frame_timing.h"
+#include "trace.h"
 
 int main()
 {
@@ -29,5 +31,11 @@ int main()
         "}                                            \n";
     egl_load_shader(&egl_ctx, vertex_shader_src, fragment_shader_src);
 
+    // fps plus per-stage p50/p90/p99/max every second, trace to $TRACE_FILE if set
+    timing_init(0, 1000, NULL);
+    trace_init(NULL, 0);
+    trace_thread_name("render");
     x11_window_loop(&x11_ctx, (void (*)(void *))egl_draw, &egl_ctx);
+    timing_destroy();
+    trace_destroy();
 }
\ No newline at end of file
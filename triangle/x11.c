@@ -1,6 +1,7 @@
-#include <unistd.h>
 #include "log.h"
 #include "x11.h"
+#include "trace.h"
+#include "event_loop.h"
 
 int x11_window_create(struct x11_context *ctx)
 {
@@ -19,7 +20,7 @@ int x11_window_create(struct x11_context *ctx)
     }
 
     Window root = DefaultRootWindow(ctx->display);
-    XSetWindowAttributes swa = {.event_mask = ExposureMask | PointerMotionMask | KeyPressMask};
+    XSetWindowAttributes swa = {.event_mask = ExposureMask | StructureNotifyMask | KeyPressMask};
     ctx->win = XCreateWindow(
         ctx->display, root,
         0, 0, 100, 100, 0,
@@ -61,12 +62,31 @@ int x11_window_loop(struct x11_context *ctx, void (*draw_func)(void *data), void
         return -1;
     }
 
+    struct event_loop *events = event_loop_create();
+    if (!events)
+    {
+        logerror("event_loop_create failed");
+        return -1;
+    }
+    event_loop_add(events, ConnectionNumber(ctx->display));
+
     XEvent xev;
 
     int stop = 0;
+    // the scene is static: drawn once, then again only on expose, resize or a key
+    int redraw = 1;
 
     while (!stop)
     {
+        // sleep until the server sends something, XPending flushes our requests first
+        if ((!draw_func || !redraw) && !XPending(ctx->display))
+        {
+            TRACE_BEGIN(idle_begin);
+            event_loop_wait(events, -1);
+            TRACE_END("x11_idle", idle_begin);
+        }
+
+        TRACE_BEGIN(events_begin);
         while (XPending(ctx->display))
         {
             XNextEvent(ctx->display, &xev);
@@ -79,7 +99,17 @@ int x11_window_loop(struct x11_context *ctx, void (*draw_func)(void *data), void
                 if (XLookupString(&xev.xkey, &key_char, 1, &key, 0))
                 {
                     loginfo("keypress: %c", key_char);
+                    // dump the trace recorded so far without stopping
+                    if (key_char == 't')
+                        trace_write();
                 }
+                redraw = 1;
+            }
+            break;
+            case Expose:
+            case ConfigureNotify:
+            {
+                redraw = 1;
             }
             break;
             case ClientMessage:
@@ -98,11 +128,17 @@ int x11_window_loop(struct x11_context *ctx, void (*draw_func)(void *data), void
             }
         }
 
-        if (draw_func)
+        TRACE_END("x11_events", events_begin);
+
+        if (draw_func && redraw)
+        {
+            TRACE_BEGIN(draw_begin);
             draw_func(data);
-        else
-            usleep(10000);
+            TRACE_END("x11_draw", draw_begin);
+            redraw = 0;
+        }
     }
 
+    event_loop_destroy(events);
     return 0;
 }
\ No newline at end of file
@@ -18,6 +18,8 @@ extern "C"
 
     int x11_window_create(struct x11_context *ctx);
 
+    // pump events until the window closes, calling <draw_func> for the first frame and
+    // after every expose, resize or key; sleeps in poll on the connection in between
     int x11_window_loop(struct x11_context *ctx, void (*draw_func)(void *data), void *data);
 
 #ifdef __cplusplus